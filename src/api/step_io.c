@@ -36,6 +36,7 @@
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -65,6 +66,7 @@
 
 #define MAX_RETRIES 3
 #define STDIO_MAX_FREE_BUF 1024
+#define STDIO_MAX_WRITEV 64	/* messages written per _file_write call */
 
 struct io_buf {
 	int ref_count;
@@ -161,6 +163,9 @@ struct file_write_info {
 	bool eof;
 };
 
+static void _file_msg_free(struct file_write_info *info,
+			   struct io_buf *msg);
+
 /**********************************************************************
  * File read declarations
  **********************************************************************/
@@ -555,11 +560,26 @@ static bool _file_writable(eio_obj_t *obj)
 	return false;
 }
 
+static void _file_msg_free(struct file_write_info *info, struct io_buf *msg)
+{
+	msg->ref_count--;
+	if (msg->ref_count == 0)
+		list_enqueue(info->cio->free_outgoing, msg);
+}
+
+/*
+ * Write queued messages to the file.  Up to STDIO_MAX_WRITEV messages
+ * are drained per call, coalesced into a single writev() when no labels
+ * are needed, so a busy step does not cost one poll round per message.
+ */
 static int _file_write(eio_obj_t *obj, List objs)
 {
 	struct file_write_info *info = (struct file_write_info *) obj->arg;
-	void *ptr;
-	int n;
+	struct io_buf *msgs[STDIO_MAX_WRITEV];
+	struct iovec iov[STDIO_MAX_WRITEV];
+	struct io_buf *msg;
+	uint32_t offset;
+	int i, cnt = 0, rc = SLURM_SUCCESS;
 
 	debug2("Entering _file_write");
 	/*
@@ -576,39 +596,60 @@ static int _file_write(eio_obj_t *obj, List objs)
 	}
 
 	/*
-	 * Write message to file.
+	 * Gather messages for this file, discarding those we are ignoring
+	 * (not from info->taskid) or that arrive after an error.
 	 */
-	if (info->taskid != (uint32_t)-1
-	    && info->out_msg->header.gtaskid != info->taskid) {
-		/* we are ignoring messages not from info->taskid */
-	} else if (!info->eof) {
-		ptr = info->out_msg->data + (info->out_msg->length
-					     - info->out_remaining);
-		if ((n = write_labelled_message(obj->fd, ptr,
-					        info->out_remaining,
-					        info->out_msg->header.gtaskid,
-					        info->cio->label,
-					        info->cio->label_width)) < 0) {
-			list_enqueue(info->cio->free_outgoing, info->out_msg);
-			info->eof = true;
-			return SLURM_ERROR;
+	msg = info->out_msg;
+	offset = msg->length - info->out_remaining;
+	info->out_msg = NULL;
+	while (msg) {
+		if (info->eof || ((info->taskid != (uint32_t)-1) &&
+				  (msg->header.gtaskid != info->taskid))) {
+			_file_msg_free(info, msg);
+		} else {
+			iov[cnt].iov_base = msg->data + offset;
+			iov[cnt].iov_len  = msg->length - offset;
+			msgs[cnt++] = msg;
+			if (cnt >= STDIO_MAX_WRITEV)
+				break;
 		}
-		debug3("  wrote %d bytes", n);
-		info->out_remaining -= n;
-		if (info->out_remaining > 0)
-			return SLURM_SUCCESS;
+		offset = 0;
+		msg = list_dequeue(info->msg_queue);
+	}
+	if (cnt == 0)
+		return SLURM_SUCCESS;
+
+	/*
+	 * Write messages to file.
+	 */
+	if (info->cio->label) {
+		for (i = 0; i < cnt; i++) {
+			if (iov[i].iov_len == 0)
+				continue;
+			if (write_labelled_message(obj->fd, iov[i].iov_base,
+						   iov[i].iov_len,
+						   msgs[i]->header.gtaskid,
+						   info->cio->label,
+						   info->cio->label_width)
+			    < 0) {
+				rc = SLURM_ERROR;
+				break;
+			}
+		}
+	} else if (fd_writev_n(obj->fd, iov, cnt) < 0) {
+		rc = SLURM_ERROR;
 	}
+	if (rc != SLURM_SUCCESS)
+		info->eof = true;
 
 	/*
-	 * Free the message.
+	 * Free the messages.
 	 */
-	info->out_msg->ref_count--;
-	if (info->out_msg->ref_count == 0)
-		list_enqueue(info->cio->free_outgoing, info->out_msg);
-	info->out_msg = NULL;
+	for (i = 0; i < cnt; i++)
+		_file_msg_free(info, msgs[i]);
 	debug2("Leaving  _file_write");
 
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 /**********************************************************************
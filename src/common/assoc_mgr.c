@@ -41,6 +41,7 @@
 #include <sys/types.h>
 #include <pwd.h>
 #include <fcntl.h>
+#include <ctype.h>
 
 #include "src/common/uid.h"
 #include "src/common/xstring.h"
@@ -48,6 +49,7 @@
 #include "src/slurmdbd/read_config.h"
 
 #define ASSOC_USAGE_VERSION 1
+#define ASSOC_HASH_MIN_SIZE 256
 
 slurmdb_association_rec_t *assoc_mgr_root_assoc = NULL;
 uint32_t g_qos_max_priority = 0;
@@ -70,6 +72,165 @@ void (*update_resvs) () = NULL;
 static pthread_mutex_t locks_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t locks_cond = PTHREAD_COND_INITIALIZER;
 
+/* Hash indices into assoc_mgr_association_list, one keyed by user and
+ * account and one by id.  The chains are linked through the usage of
+ * each association and are rebuilt by _rebuild_assoc_hash whenever
+ * the list changes, under the association write lock.
+ */
+static slurmdb_association_rec_t **assoc_hash = NULL;
+static slurmdb_association_rec_t **assoc_hash_id = NULL;
+static uint32_t assoc_hash_size = 0;
+
+static uint32_t _assoc_hash_index(uint32_t uid, char *acct)
+{
+	uint32_t index = uid;
+
+	/* accounts are compared case insensitive */
+	if (acct) {
+		for ( ; *acct; acct++)
+			index = (index * 31) + tolower((int)*acct);
+	}
+	return index & (assoc_hash_size - 1);
+}
+
+static void _rebuild_assoc_hash(void)
+{
+	slurmdb_association_rec_t *assoc = NULL;
+	slurmdb_association_rec_t **assoc_tail = NULL;
+	ListIterator itr = NULL;
+	uint32_t size = ASSOC_HASH_MIN_SIZE, inx;
+
+	if (assoc_mgr_association_list) {
+		while (size < list_count(assoc_mgr_association_list))
+			size <<= 1;
+	}
+
+	if (size != assoc_hash_size) {
+		xfree(assoc_hash);
+		xfree(assoc_hash_id);
+		assoc_hash_size = size;
+		assoc_hash = xmalloc(sizeof(slurmdb_association_rec_t *)
+				     * assoc_hash_size);
+		assoc_hash_id = xmalloc(sizeof(slurmdb_association_rec_t *)
+					* assoc_hash_size);
+	} else {
+		memset(assoc_hash, 0,
+		       sizeof(slurmdb_association_rec_t *) * assoc_hash_size);
+		memset(assoc_hash_id, 0,
+		       sizeof(slurmdb_association_rec_t *) * assoc_hash_size);
+	}
+
+	if (!assoc_mgr_association_list)
+		return;
+
+	/* Keep the user/account chains in list order since the
+	   lookup returns the first match in the list. */
+	assoc_tail = xmalloc(sizeof(slurmdb_association_rec_t *)
+			     * assoc_hash_size);
+	itr = list_iterator_create(assoc_mgr_association_list);
+	while ((assoc = list_next(itr))) {
+		if (!assoc->usage)
+			assoc->usage = create_assoc_mgr_association_usage();
+
+		inx = _assoc_hash_index(assoc->uid, assoc->acct);
+		assoc->usage->assoc_next = NULL;
+		if (assoc_tail[inx])
+			assoc_tail[inx]->usage->assoc_next = assoc;
+		else
+			assoc_hash[inx] = assoc;
+		assoc_tail[inx] = assoc;
+
+		inx = assoc->id & (assoc_hash_size - 1);
+		assoc->usage->assoc_next_id = assoc_hash_id[inx];
+		assoc_hash_id[inx] = assoc;
+	}
+	list_iterator_destroy(itr);
+	xfree(assoc_tail);
+}
+
+static void _free_assoc_hash(void)
+{
+	xfree(assoc_hash);
+	xfree(assoc_hash_id);
+	assoc_hash_size = 0;
+}
+
+/* assoc_mgr association lock must be held before calling this */
+static slurmdb_association_rec_t *_find_assoc_rec_id(uint32_t assoc_id)
+{
+	slurmdb_association_rec_t *assoc;
+
+	if (!assoc_hash_id)
+		return NULL;
+
+	assoc = assoc_hash_id[assoc_id & (assoc_hash_size - 1)];
+	while (assoc) {
+		if (assoc->id == assoc_id)
+			return assoc;
+		assoc = assoc->usage->assoc_next_id;
+	}
+	return NULL;
+}
+
+/* Find the association of the given user, account and partition (and
+ * cluster on the slurmdbd).  If a partition is requested but there
+ * isn't an association for it the one without a partition is returned.
+ * assoc_mgr association lock must be held before calling this.
+ */
+static slurmdb_association_rec_t *_find_assoc_rec(
+	slurmdb_association_rec_t *assoc)
+{
+	slurmdb_association_rec_t *found_assoc = NULL;
+	slurmdb_association_rec_t *ret_assoc = NULL;
+
+	if (!assoc_hash)
+		return NULL;
+
+	found_assoc = assoc_hash[_assoc_hash_index(assoc->uid, assoc->acct)];
+	for ( ; found_assoc; found_assoc = found_assoc->usage->assoc_next) {
+		if (assoc->uid != found_assoc->uid) {
+			debug4("not the right user %u != %u",
+			       assoc->uid, found_assoc->uid);
+			continue;
+		}
+
+		if (found_assoc->acct
+		    && strcasecmp(assoc->acct, found_assoc->acct)) {
+			debug4("not the right account %s != %s",
+			       assoc->acct, found_assoc->acct);
+			continue;
+		}
+
+		/* only check for on the slurmdbd */
+		if (!assoc_mgr_cluster_name && found_assoc->cluster
+		    && strcasecmp(assoc->cluster, found_assoc->cluster)) {
+			debug4("not the right cluster");
+			continue;
+		}
+
+		if (assoc->partition) {
+			if (!found_assoc->partition) {
+				ret_assoc = found_assoc;
+				debug3("found association "
+				       "for no partition");
+				continue;
+			} else if (strcasecmp(assoc->partition,
+					      found_assoc->partition)) {
+				debug4("not the right partition");
+				continue;
+			}
+		} else if (found_assoc->partition) {
+			debug4("partition specific association "
+			       "looking for one without.");
+			continue;
+		}
+
+		return found_assoc;
+	}
+
+	return ret_assoc;
+}
+
 /* you should check for assoc == NULL before this function */
 static void _normalize_assoc_shares(slurmdb_association_rec_t *assoc)
 {
@@ -213,6 +374,7 @@ static int _change_user_name(slurmdb_user_rec_t *user)
 			}
 		}
 		list_iterator_destroy(itr);
+		_rebuild_assoc_hash();
 	}
 
 	if (assoc_mgr_wckey_list) {
@@ -571,6 +733,7 @@ static int _post_association_list(List assoc_list)
 	list_iterator_destroy(itr);
 
 	slurmdb_sort_hierarchical_assoc_list(assoc_list);
+	_rebuild_assoc_hash();
 
 	//END_TIMER2("load_associations");
 	return SLURM_SUCCESS;
@@ -699,6 +862,7 @@ static int _get_assoc_mgr_association_list(void *db_conn, int enforce)
 		   isn't anything there */
 		assoc_mgr_association_list =
 			list_create(slurmdb_destroy_association_rec);
+		_rebuild_assoc_hash();
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
 			error("_get_assoc_mgr_association_list: "
@@ -837,7 +1001,6 @@ static int _refresh_assoc_mgr_association_list(void *db_conn, int enforce)
 	List current_assocs = NULL;
 	uid_t uid = getuid();
 	ListIterator curr_itr = NULL;
-	ListIterator assoc_mgr_itr = NULL;
 	slurmdb_association_rec_t *curr_assoc = NULL, *assoc = NULL;
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
 				   NO_LOCK, WRITE_LOCK, NO_LOCK };
@@ -882,17 +1045,13 @@ static int _refresh_assoc_mgr_association_list(void *db_conn, int enforce)
 	}
 
 	curr_itr = list_iterator_create(current_assocs);
-	assoc_mgr_itr = list_iterator_create(assoc_mgr_association_list);
 
 	/* add used limits We only look for the user associations to
 	 * do the parents since a parent may have moved */
 	while ((curr_assoc = list_next(curr_itr))) {
 		if (!curr_assoc->user)
 			continue;
-		while ((assoc = list_next(assoc_mgr_itr))) {
-			if (assoc->id == curr_assoc->id)
-				break;
-		}
+		assoc = _find_assoc_rec_id(curr_assoc->id);
 
 		while (assoc) {
 			_addto_used_info(assoc, curr_assoc);
@@ -900,11 +1059,9 @@ static int _refresh_assoc_mgr_association_list(void *db_conn, int enforce)
 			   different than the one we are updating from */
 			assoc = assoc->usage->parent_assoc_ptr;
 		}
-		list_iterator_reset(assoc_mgr_itr);
 	}
 
 	list_iterator_destroy(curr_itr);
-	list_iterator_destroy(assoc_mgr_itr);
 
 	assoc_mgr_unlock(&locks);
 
@@ -1191,6 +1348,7 @@ extern int assoc_mgr_fini(char *state_save_location)
 	if (assoc_mgr_wckey_list)
 		list_destroy(assoc_mgr_wckey_list);
 	xfree(assoc_mgr_cluster_name);
+	_free_assoc_hash();
 	assoc_mgr_association_list = NULL;
 	assoc_mgr_qos_list = NULL;
 	assoc_mgr_user_list = NULL;
@@ -1254,6 +1412,7 @@ extern assoc_mgr_association_usage_t *create_assoc_mgr_association_usage()
 
 	usage->level_shares = NO_VAL;
 	usage->shares_norm = (double)NO_VAL;
+	usage->fs_factor = (double)NO_VAL;
 	usage->usage_efctv = 0;
 	usage->usage_norm = (long double)NO_VAL;
 	usage->usage_raw = 0;
@@ -1357,8 +1516,6 @@ extern int assoc_mgr_fill_in_assoc(void *db_conn,
 				   int enforce,
 				   slurmdb_association_rec_t **assoc_pptr)
 {
-	ListIterator itr = NULL;
-	slurmdb_association_rec_t * found_assoc = NULL;
 	slurmdb_association_rec_t * ret_assoc = NULL;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
@@ -1432,62 +1589,10 @@ extern int assoc_mgr_fill_in_assoc(void *db_conn,
 /* 	     assoc->user, assoc->uid, assoc->acct, */
 /* 	     assoc->cluster, assoc->partition); */
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(assoc_mgr_association_list);
-	while ((found_assoc = list_next(itr))) {
-		if (assoc->id) {
-			if (assoc->id == found_assoc->id) {
-				ret_assoc = found_assoc;
-				break;
-			}
-			continue;
-		} else {
-			if (assoc->uid == NO_VAL
-			    && found_assoc->uid != NO_VAL) {
-				debug3("we are looking for a "
-				       "nonuser association");
-				continue;
-			} else if (assoc->uid != found_assoc->uid) {
-				debug4("not the right user %u != %u",
-				       assoc->uid, found_assoc->uid);
-				continue;
-			}
-
-			if (found_assoc->acct
-			    && strcasecmp(assoc->acct, found_assoc->acct)) {
-				debug4("not the right account %s != %s",
-				       assoc->acct, found_assoc->acct);
-				continue;
-			}
-
-			/* only check for on the slurmdbd */
-			if (!assoc_mgr_cluster_name && found_assoc->cluster
-			    && strcasecmp(assoc->cluster,
-					  found_assoc->cluster)) {
-				debug4("not the right cluster");
-				continue;
-			}
-
-			if (assoc->partition) {
-				if (!found_assoc->partition) {
-					ret_assoc = found_assoc;
-					debug3("found association "
-					       "for no partition");
-					continue;
-				} else if (strcasecmp(assoc->partition,
-						      found_assoc->partition)) {
-					debug4("not the right partition");
-					continue;
-				}
-			} else if (found_assoc->partition) {
-				debug4("partition specific association "
-				       "looking for one without.");
-				continue;
-			}
-		}
-		ret_assoc = found_assoc;
-		break;
-	}
-	list_iterator_destroy(itr);
+	if (assoc->id)
+		ret_assoc = _find_assoc_rec_id(assoc->id);
+	else
+		ret_assoc = _find_assoc_rec(assoc);
 
 	if (!ret_assoc) {
 		assoc_mgr_unlock(&locks);
@@ -2625,6 +2730,10 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update)
 		slurmdb_sort_hierarchical_assoc_list(
 			assoc_mgr_association_list);
 
+	/* associations were added, removed or moved around */
+	if (parents_changed || resort || run_update_resvs)
+		_rebuild_assoc_hash();
+
 	list_iterator_destroy(itr);
 	assoc_mgr_unlock(&locks);
 
@@ -3197,7 +3306,6 @@ extern int assoc_mgr_validate_assoc_id(void *db_conn,
 				       uint32_t assoc_id,
 				       int enforce)
 {
-	ListIterator itr = NULL;
 	slurmdb_association_rec_t * found_assoc = NULL;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
@@ -3218,12 +3326,7 @@ extern int assoc_mgr_validate_assoc_id(void *db_conn,
 		return SLURM_SUCCESS;
 	}
 
-	itr = list_iterator_create(assoc_mgr_association_list);
-	while ((found_assoc = list_next(itr))) {
-		if (assoc_id == found_assoc->id)
-			break;
-	}
-	list_iterator_destroy(itr);
+	found_assoc = _find_assoc_rec_id(assoc_id);
 	assoc_mgr_unlock(&locks);
 
 	if (found_assoc || !(enforce & ACCOUNTING_ENFORCE_ASSOCS))
@@ -3574,7 +3677,6 @@ extern int load_assoc_usage(char *state_save_location)
 	char *data = NULL, *state_file;
 	Buf buffer;
 	time_t buf_time;
-	ListIterator itr = NULL;
 	assoc_mgr_lock_t locks = { WRITE_LOCK, READ_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -3629,7 +3731,6 @@ extern int load_assoc_usage(char *state_save_location)
 
 	safe_unpack_time(&buf_time, buffer);
 
-	itr = list_iterator_create(assoc_mgr_association_list);
 	while (remaining_buf(buffer) > 0) {
 		uint32_t assoc_id = 0;
 		uint32_t grp_used_wall = 0;
@@ -3639,9 +3740,7 @@ extern int load_assoc_usage(char *state_save_location)
 		safe_unpack32(&assoc_id, buffer);
 		safe_unpack64(&usage_raw, buffer);
 		safe_unpack32(&grp_used_wall, buffer);
-		while ((assoc = list_next(itr)))
-			if (assoc->id == assoc_id)
-				break;
+		assoc = _find_assoc_rec_id(assoc_id);
 
 		/* We want to do this all the way up to and including
 		   root.  This way we can keep track of how much usage
@@ -3654,9 +3753,7 @@ extern int load_assoc_usage(char *state_save_location)
 
 			assoc = assoc->usage->parent_assoc_ptr;
 		}
-		list_iterator_reset(itr);
 	}
-	list_iterator_destroy(itr);
 	assoc_mgr_unlock(&locks);
 
 	free_buf(buffer);
@@ -3665,8 +3762,6 @@ extern int load_assoc_usage(char *state_save_location)
 unpack_error:
 	if (buffer)
 		free_buf(buffer);
-	if (itr)
-		list_iterator_destroy(itr);
 	assoc_mgr_unlock(&locks);
 	return SLURM_ERROR;
 }
@@ -3986,6 +4081,7 @@ extern int assoc_mgr_set_missing_uids()
 			}
 		}
 		list_iterator_destroy(itr);
+		_rebuild_assoc_hash();
 	}
 
 	if (assoc_mgr_wckey_list) {
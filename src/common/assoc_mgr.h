@@ -120,6 +120,19 @@ struct assoc_mgr_association_usage {
 
 	double shares_norm;     /* normalized shares (DON'T PACK) */
 
+	double fs_factor;       /* fairshare factor cached by the
+				 * multifactor decay thread for the
+				 * current cycle, NO_VAL if stale
+				 * (DON'T PACK) */
+
+	slurmdb_association_rec_t *assoc_next; /* next association in
+						* the same user/account
+						* hash bucket
+						* (DON'T PACK) */
+	slurmdb_association_rec_t *assoc_next_id; /* next association in
+						   * the same id hash
+						   * bucket (DON'T PACK) */
+
 	long double usage_efctv;/* effective, normalized usage (DON'T PACK) */
 	long double usage_norm;	/* normalized usage (DON'T PACK) */
 	long double usage_raw;	/* measure of resource usage (DON'T PACK) */
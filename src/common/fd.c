@@ -44,6 +44,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/uio.h>
 
 #include "src/common/macros.h"
 #include "src/common/fd.h"
@@ -243,6 +244,33 @@ ssize_t fd_write_n(int fd, void *buf, size_t n)
 }
 
 
+ssize_t fd_writev_n(int fd, struct iovec *iov, int iovcnt)
+{
+	ssize_t n, total = 0;
+
+	while (iovcnt > 0) {
+		if ((n = writev(fd, iov, iovcnt)) < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN) ||
+			    (errno == EWOULDBLOCK))
+				continue;
+			else
+				return(-1);
+		}
+		total += n;
+		while ((iovcnt > 0) && (n >= iov->iov_len)) {
+			n -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base += n;
+			iov->iov_len  -= n;
+		}
+	}
+	return(total);
+}
+
+
 ssize_t fd_read_line(int fd, void *buf, size_t maxlen)
 {
 	ssize_t n, rc;
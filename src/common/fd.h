@@ -45,6 +45,7 @@
 #endif /* HAVE_CONFIG_H */
 
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
@@ -136,6 +137,14 @@ ssize_t fd_write_n(int fd, void *buf, size_t n);
  *  Returns the number of bytes written, or -1 on error.
  */
 
+ssize_t fd_writev_n(int fd, struct iovec *iov, int iovcnt);
+/*
+ *  Writes all (iovcnt) buffers of (iov) to (fd), retrying partial writes
+ *    and EAGAIN even if (fd) is in non-blocking mode.
+ *  The (iov) array is modified as data is written.
+ *  Returns the number of bytes written, or -1 on error.
+ */
+
 ssize_t fd_read_line(int fd, void *buf, size_t maxlen);
 /*
  *  Reads at most (maxlen-1) bytes up to a newline from (fd) into (buf).
@@ -61,6 +61,9 @@
 #endif /* WITH_PTHREADS */
 
 #define MAX_RETRIES 3
+/* Seconds a credential packed by start_msg_tree_width() is shared for,
+ * well short of the default munge credential TTL of 300 seconds */
+#define PACKED_CRED_MAX_AGE 60
 
 typedef struct {
 	pthread_cond_t *notify;
@@ -69,6 +72,9 @@ typedef struct {
 	int timeout;
 	hostlist_t tree_hl;
 	pthread_mutex_t *tree_mutex;
+	Buf packed;
+	uint32_t packed_body_len;
+	time_t packed_time;
 } fwd_tree_t;
 
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
@@ -312,6 +318,8 @@ void *_fwd_tree_thread(void *arg)
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
 	send_msg.data = fwd_tree->orig_msg->data;
+	send_msg.packed = fwd_tree->packed;
+	send_msg.packed_body_len = fwd_tree->packed_body_len;
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
@@ -343,6 +351,13 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		/* Retries can run for a long time, don't send a
+		 * credential that may have expired on the way */
+		if (send_msg.packed &&
+		    (difftime(time(NULL), fwd_tree->packed_time) >=
+		     PACKED_CRED_MAX_AGE))
+			send_msg.packed = NULL;
+
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
 
@@ -374,9 +389,12 @@ void *_fwd_tree_thread(void *arg)
 
 		free(name);
 
-		/* check for error and try again */
-		if(errno == SLURM_COMMUNICATIONS_CONNECTION_ERROR)
- 			continue;
+		/* check for error and try again, with a credential
+		 * of its own for each send from now on */
+		if(errno == SLURM_COMMUNICATIONS_CONNECTION_ERROR) {
+			send_msg.packed = NULL;
+			continue;
+		}
 
 		break;
 	}
@@ -519,6 +537,20 @@ extern int forward_msg(forward_struct_t *forward_struct,
  *		     containing type (ret_data_info_t).
  */
 extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
+{
+	return start_msg_tree_width(hl, msg, timeout, 0);
+}
+
+/*
+ * start_msg_tree_width - same as start_msg_tree(), but send the message
+ *                   directly to at most tree_width nodes, each of them
+ *                   forwarding it to its share of the others.
+ *
+ * IN: tree_width  - uint16_t     - number of nodes to send to directly,
+ *                                  zero for the configured TreeWidth
+ */
+extern List start_msg_tree_width(hostlist_t hl, slurm_msg_t *msg, int timeout,
+				 uint16_t tree_width)
 {
 	int *span = NULL;
 	fwd_tree_t *fwd_tree = NULL;
@@ -529,6 +561,8 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	char *name = NULL;
 	int thr_count = 0;
 	int host_count = 0;
+	slurm_msg_t packed_msg;
+	time_t packed_time;
 
 	xassert(hl);
 	xassert(msg);
@@ -536,7 +570,15 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	hostlist_uniq(hl);
 	host_count = hostlist_count(hl);
 
-	span = set_span(host_count, 0);
+	span = set_span(host_count, tree_width);
+
+	/* Create the credential and pack the message once for all threads,
+	 * on failure each thread packs it again (and reports the error) */
+	slurm_msg_t_init(&packed_msg);
+	packed_msg.msg_type = msg->msg_type;
+	packed_msg.data = msg->data;
+	(void) slurm_pack_msg_body(&packed_msg);
+	packed_time = time(NULL);
 
 	slurm_mutex_init(&tree_mutex);
 	pthread_cond_init(&notify, NULL);
@@ -559,6 +601,9 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 		fwd_tree->timeout = timeout;
 		fwd_tree->notify = &notify;
 		fwd_tree->tree_mutex = &tree_mutex;
+		fwd_tree->packed = packed_msg.packed;
+		fwd_tree->packed_body_len = packed_msg.packed_body_len;
+		fwd_tree->packed_time = packed_time;
 
 		if (fwd_tree->timeout <= 0) {
 			/* convert secs to msec */
@@ -601,6 +646,8 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 
 	slurm_mutex_destroy(&tree_mutex);
 	pthread_cond_destroy(&notify);
+	if (packed_msg.packed)
+		free_buf(packed_msg.packed);
 
 	return ret_list;
 }
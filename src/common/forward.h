@@ -103,6 +103,17 @@ extern int forward_msg(forward_struct_t *forward_struct,
  */
 extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout);
 
+/*
+ * start_msg_tree_width - same as start_msg_tree(), but send the message
+ *                   directly to at most tree_width nodes, each of them
+ *                   forwarding it to its share of the others.
+ *
+ * IN: tree_width  - uint16_t     - number of nodes to send to directly,
+ *                                  zero for the configured TreeWidth
+ */
+extern List start_msg_tree_width(hostlist_t hl, slurm_msg_t *msg, int timeout,
+				 uint16_t tree_width);
+
 /*
  * mark_as_failed_forward- mark a node as failed and add it to "ret_list"
  *
@@ -2465,6 +2465,17 @@ static void _validate_gres_node_cpus(gres_node_state_t *node_gres_ptr,
 	}
 }
 
+/* Return the number of CPUs in topo_cpus_bitmap which are also available
+ * in node_cpu_bitmap (all of them if node_cpu_bitmap is NULL) */
+static int _topo_cpu_cnt(bitstr_t *topo_cpus_bitmap, bitstr_t *node_cpu_bitmap)
+{
+	if (node_cpu_bitmap == NULL)
+		return bit_set_count(topo_cpus_bitmap);
+	if (bit_size(topo_cpus_bitmap) != bit_size(node_cpu_bitmap))
+		return 0;
+	return bit_overlap(topo_cpus_bitmap, node_cpu_bitmap);
+}
+
 extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			  bool use_total_gres, bitstr_t *cpu_bitmap,
 			  int cpu_start_bit, int cpu_end_bit, bool *topo_set,
@@ -2474,12 +2485,17 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
 	uint32_t *cpus_avail = NULL, cpu_cnt = 0;
-	bitstr_t *alloc_cpu_bitmap = NULL;
+	bitstr_t *alloc_cpu_bitmap = NULL, *node_cpu_bitmap = NULL;
+
+	if (job_gres_ptr->gres_cnt_alloc && node_gres_ptr->topo_cnt) {
+		/* Test the node-wide count first, it is a necessary condition
+		 * for both of the topology tests below and much cheaper */
+		gres_avail = node_gres_ptr->gres_cnt_avail;
+		if (!use_total_gres)
+			gres_avail -= node_gres_ptr->gres_cnt_alloc;
+		if (job_gres_ptr->gres_cnt_alloc > gres_avail)
+			return (uint32_t) 0;	/* insufficient, gres to use */
 
-	if (job_gres_ptr->gres_cnt_alloc && node_gres_ptr->topo_cnt &&
-	    *topo_set) {
-		/* Need to determine how many gres available for these
-		 * specific CPUs */
 		if (cpu_bitmap) {
 			cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
 			if (cpus_ctld < 1) {
@@ -2489,51 +2505,40 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 			_validate_gres_node_cpus(node_gres_ptr, cpus_ctld,
 						 node_name);
+			/* Extract this node's CPUs once so each topology
+			 * entry is tested a word at a time */
+			node_cpu_bitmap = bit_alloc(cpus_ctld);
+			for (j=0; j<cpus_ctld; j++) {
+				if (bit_test(cpu_bitmap, cpu_start_bit+j))
+					bit_set(node_cpu_bitmap, j);
+			}
 		} else {
 			cpus_ctld = bit_size(node_gres_ptr->
 					     topo_cpus_bitmap[0]);
 		}
+	}
+
+	if (job_gres_ptr->gres_cnt_alloc && node_gres_ptr->topo_cnt &&
+	    *topo_set) {
+		/* Need to determine how many gres available for these
+		 * specific CPUs */
+		gres_avail = 0;
 		for (i=0; i<node_gres_ptr->topo_cnt; i++) {
-			for (j=0; j<cpus_ctld; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (!bit_test(node_gres_ptr->
-					      topo_cpus_bitmap[i], j))
-					continue; /* not avail for this gres */
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
-				break;
+			if (_topo_cpu_cnt(node_gres_ptr->topo_cpus_bitmap[i],
+					  node_cpu_bitmap) == 0)
+				continue; /* not avail for this gres */
+			gres_avail += node_gres_ptr->topo_gres_cnt_avail[i];
+			if (!use_total_gres) {
+				gres_avail -= node_gres_ptr->
+					      topo_gres_cnt_alloc[i];
 			}
 		}
+		FREE_NULL_BITMAP(node_cpu_bitmap);
 		if (job_gres_ptr->gres_cnt_alloc > gres_avail)
 			return (uint32_t) 0;	/* insufficient, gres to use */
 		return NO_VAL;
 	} else if (job_gres_ptr->gres_cnt_alloc && node_gres_ptr->topo_cnt) {
 		/* Need to determine which specific CPUs can be used */
-		gres_avail = node_gres_ptr->gres_cnt_avail;
-		if (!use_total_gres)
-			gres_avail -= node_gres_ptr->gres_cnt_alloc;
-		if (job_gres_ptr->gres_cnt_alloc > gres_avail)
-			return (uint32_t) 0;	/* insufficient, gres to use */
-
-		if (cpu_bitmap) {
-			cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
-			if (cpus_ctld < 1) {
-				error("gres/%s: job %u cpus on node %s < 1",
-				      gres_name, job_id, node_name);
-				return (uint32_t) 0;
-			}
-			_validate_gres_node_cpus(node_gres_ptr, cpus_ctld,
-						 node_name);
-		} else {
-			cpus_ctld = bit_size(node_gres_ptr->
-					     topo_cpus_bitmap[0]);
-		}
 		cpus_avail = xmalloc(sizeof(uint32_t)*node_gres_ptr->topo_cnt);
 		for (i=0; i<node_gres_ptr->topo_cnt; i++) {
 			if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
@@ -2542,16 +2547,11 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 			     node_gres_ptr->topo_gres_cnt_avail[i]))
 				continue;
-			for (j=0; j<cpus_ctld; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (bit_test(node_gres_ptr->
-					     topo_cpus_bitmap[i], j)) {
-					cpus_avail[i]++;
-				}
-			}
+			cpus_avail[i] = _topo_cpu_cnt(node_gres_ptr->
+						      topo_cpus_bitmap[i],
+						      node_cpu_bitmap);
 		}
+		FREE_NULL_BITMAP(node_cpu_bitmap);
 
 		/* Pick the topology entries with the most CPUs available */
 		alloc_cpu_bitmap = bit_alloc(cpus_ctld);
@@ -2625,7 +2625,7 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 {
 	int i;
 	uint32_t cpu_cnt, tmp_cnt;
-	ListIterator job_gres_iter,  node_gres_iter;
+	ListIterator job_gres_iter;
 	gres_state_t *job_gres_ptr, *node_gres_ptr;
 	bool topo_set = false;
 
@@ -2640,13 +2640,8 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 	slurm_mutex_lock(&gres_context_lock);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		node_gres_ptr = list_find_first(node_gres_list, _gres_find_id,
+						&job_gres_ptr->plugin_id);
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			cpu_cnt = 0;
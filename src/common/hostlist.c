@@ -259,8 +259,21 @@ struct hostlist {
 	/* list of iterators */
 	struct hostlist_iterator *ilist;
 
+	/* HOSTLIST_SORTED if the ranges are ordered and disjoint so that
+	 * hostlist_find() may use a binary search, HOSTLIST_UNSORTED if
+	 * not, HOSTLIST_SORT_UNKNOWN if not yet checked since the last
+	 * change which could reorder the ranges */
+	int sorted;
+
+	/* number of hosts before each range when sorted, NULL if stale */
+	int *offset;
+
 };
 
+#define HOSTLIST_SORT_UNKNOWN	-1
+#define HOSTLIST_UNSORTED	0
+#define HOSTLIST_SORTED		1
+
 
 /* a hostset is a wrapper around a hostlist */
 struct hostset {
@@ -394,6 +407,12 @@ static void        hostlist_collapse(hostlist_t hl);
 static hostlist_t _hostlist_create(const char *, char *, char *, int);
 static void        hostlist_shift_iterators(hostlist_t, int, int, int);
 static int        _attempt_range_join(hostlist_t, int);
+static int        _hostrange_searchable(hostrange_t, hostrange_t);
+static int        _hostlist_sorted(hostlist_t);
+static int        _hostlist_bsearch(hostlist_t, hostname_t);
+static int *      _hostlist_offsets(hostlist_t);
+static void       _hostlist_clear_offsets(hostlist_t);
+static void       _hostlist_delete_num(hostlist_t, int, unsigned long);
 static int        _is_bracket_needed(hostlist_t, int);
 
 static hostlist_iterator_t hostlist_iterator_new(void);
@@ -1351,6 +1370,8 @@ static hostlist_t hostlist_new(void)
 	new->nranges = 0;
 	new->nhosts = 0;
 	new->ilist = NULL;
+	new->sorted = HOSTLIST_SORTED;
+	new->offset = NULL;
 	return new;
 
 fail2:
@@ -1413,6 +1434,7 @@ static int hostlist_push_range(hostlist_t hl, hostrange_t hr)
 	if (hl->size == hl->nranges && !hostlist_expand(hl))
 		goto error;
 
+	_hostlist_clear_offsets(hl);
 	if (hl->nranges > 0
 	    && hostrange_prefix_cmp(tail, hr) == 0
 	    && tail->hi == hr->lo - 1
@@ -1422,6 +1444,9 @@ static int hostlist_push_range(hostlist_t hl, hostrange_t hr)
 		hostrange_t new = hostrange_copy(hr);
 		if (new == NULL)
 			goto error;
+		if ((hl->sorted == HOSTLIST_SORTED) &&
+		    !_hostrange_searchable(hl->nranges ? tail : NULL, new))
+			hl->sorted = HOSTLIST_UNSORTED;
 		hl->hr[hl->nranges++] = new;
 	}
 
@@ -1453,6 +1478,7 @@ hostlist_push_hr(hostlist_t hl, char *prefix, unsigned long lo,
 
 /* Insert a range object hr into position n of the hostlist hl
  * Assumes that hl->mutex is already held by calling process
+ * The caller must reset hl->sorted unless hr only splits an existing range
  */
 static int hostlist_insert_range(hostlist_t hl, hostrange_t hr, int n)
 {
@@ -1470,6 +1496,8 @@ static int hostlist_insert_range(hostlist_t hl, hostrange_t hr, int n)
 	if (hl->size == hl->nranges && !hostlist_expand(hl))
 		return 0;
 
+	_hostlist_clear_offsets(hl);
+
 	/* copy new hostrange into slot "n" in array */
 	tmp = hl->hr[n];
 	hl->hr[n] = hostrange_copy(hr);
@@ -1503,6 +1531,7 @@ static void hostlist_delete_range(hostlist_t hl, int n)
 	assert(hl->magic == HOSTLIST_MAGIC);
 	assert(n < hl->nranges && n >= 0);
 
+	_hostlist_clear_offsets(hl);
 	old = hl->hr[n];
 	for (i = n; i < hl->nranges - 1; i++)
 		hl->hr[i] = hl->hr[i + 1];
@@ -1974,6 +2003,7 @@ hostlist_t hostlist_copy(const hostlist_t hl)
 
 	new->nranges = hl->nranges;
 	new->nhosts = hl->nhosts;
+	new->sorted = hl->sorted;
 	if (new->nranges > new->size)
 		hostlist_resize(new, new->nranges);
 
@@ -2000,6 +2030,7 @@ void hostlist_destroy(hostlist_t hl)
 	for (i = 0; i < hl->nranges; i++)
 		hostrange_destroy(hl->hr[i]);
 	free(hl->hr);
+	_hostlist_clear_offsets(hl);
 	assert(hl->magic = 0x1);
 	UNLOCK_HOSTLIST(hl);
 	mutex_destroy(&hl->mutex);
@@ -2088,6 +2119,7 @@ char *hostlist_pop(hostlist_t hl)
 		hostrange_t hr = hl->hr[hl->nranges - 1];
 		host = hostrange_pop(hr);
 		hl->nhosts--;
+		_hostlist_clear_offsets(hl);
 		if (hostrange_empty(hr)) {
 			hostrange_destroy(hl->hr[--hl->nranges]);
 			hl->hr[hl->nranges] = NULL;
@@ -2137,6 +2169,7 @@ char *hostlist_shift(hostlist_t hl)
 
 		host = hostrange_shift(hr);
 		hl->nhosts--;
+		_hostlist_clear_offsets(hl);
 
 		if (hostrange_empty(hr)) {
 			hostlist_delete_range(hl, 0);
@@ -2171,6 +2204,7 @@ char *hostlist_pop_range(hostlist_t hl)
 	while (i >= 0 && hostrange_within_range(tail, hl->hr[i]))
 		i--;
 
+	_hostlist_clear_offsets(hl);
 	for (i++; i < hl->nranges; i++) {
 		hostlist_push_range(hltmp, hl->hr[i]);
 		hostrange_destroy(hl->hr[i]);
@@ -2202,6 +2236,7 @@ char *hostlist_shift_range(hostlist_t hl)
 		return NULL;
 	}
 
+	_hostlist_clear_offsets(hl);
 	i = 0;
 	do {
 		hostlist_push_range(hltmp, hl->hr[i]);
@@ -2253,9 +2288,23 @@ int hostlist_delete(hostlist_t hl, const char *hosts)
 int hostlist_delete_host(hostlist_t hl, const char *hostname)
 {
 	int n;
+	hostname_t hn;
 
 	if(!hl)
 		return -1;
+
+	hn = hostname_create(hostname);
+	LOCK_HOSTLIST(hl);
+	if (hostname_suffix_is_valid(hn) && _hostlist_sorted(hl)) {
+		if ((n = _hostlist_bsearch(hl, hn)) >= 0)
+			_hostlist_delete_num(hl, n, hn->num);
+		UNLOCK_HOSTLIST(hl);
+		hostname_destroy(hn);
+		return n >= 0 ? 1 : 0;
+	}
+	UNLOCK_HOSTLIST(hl);
+	hostname_destroy(hn);
+
 	n = hostlist_find(hl, hostname);
 
 	if (n >= 0)
@@ -2337,29 +2386,36 @@ int hostlist_delete_nth(hostlist_t hl, int n)
 		hostrange_t hr = hl->hr[i];
 
 		if (n <= (num_in_range - 1 + count)) {
-			unsigned long num = hr->lo + n - count;
-			hostrange_t new;
-
-			if (hr->singlehost) { /* this wasn't a range */
-				hostlist_delete_range(hl, i);
-			} else if ((new = hostrange_delete_host(hr, num))) {
-				hostlist_insert_range(hl, new, i + 1);
-				hostrange_destroy(new);
-			} else if (hostrange_empty(hr))
-				hostlist_delete_range(hl, i);
-
-			goto done;
+			_hostlist_delete_num(hl, i, hr->lo + n - count);
+			break;
 		} else
 			count += num_in_range;
 
 	}
 
-done:
 	UNLOCK_HOSTLIST(hl);
-	hl->nhosts--;
 	return 1;
 }
 
+/* Delete the host numbered num from the range at position i
+ * Assumes the hostlist lock is already held. Updates hl->nhosts
+ */
+static void _hostlist_delete_num(hostlist_t hl, int i, unsigned long num)
+{
+	hostrange_t hr = hl->hr[i];
+	hostrange_t new;
+
+	_hostlist_clear_offsets(hl);
+	if (hr->singlehost) { /* this wasn't a range */
+		hostlist_delete_range(hl, i);
+	} else if ((new = hostrange_delete_host(hr, num))) {
+		hostlist_insert_range(hl, new, i + 1);
+		hostrange_destroy(new);
+	} else if (hostrange_empty(hr))
+		hostlist_delete_range(hl, i);
+	hl->nhosts--;
+}
+
 int hostlist_count(hostlist_t hl)
 {
 	int retval;
@@ -2384,6 +2440,14 @@ int hostlist_find(hostlist_t hl, const char *hostname)
 
 	LOCK_HOSTLIST(hl);
 
+	if (hostname_suffix_is_valid(hn) && _hostlist_sorted(hl)) {
+		if ((i = _hostlist_bsearch(hl, hn)) >= 0) {
+			ret = _hostlist_offsets(hl)[i];
+			ret += hn->num - hl->hr[i]->lo;
+		}
+		goto done;
+	}
+
 	for (i = 0, count = 0; i < hl->nranges; i++) {
 		if (hostrange_hn_within(hl->hr[i], hn)) {
 			if (hostname_suffix_is_valid(hn))
@@ -2423,6 +2487,8 @@ void hostlist_sort(hostlist_t hl)
 	}
 
 	qsort(hl->hr, hl->nranges, sizeof(hostrange_t), &_cmp);
+	hl->sorted = HOSTLIST_SORT_UNKNOWN;
+	_hostlist_clear_offsets(hl);
 
 	/* reset all iterators */
 	for (i = hl->ilist; i; i = i->next)
@@ -2466,6 +2532,8 @@ static void hostlist_coalesce(hostlist_t hl)
 	hostrange_t new;
 
 	LOCK_HOSTLIST(hl);
+	hl->sorted = HOSTLIST_SORT_UNKNOWN;
+	_hostlist_clear_offsets(hl);
 
 	for (i = hl->nranges - 1; i > 0; i--) {
 
@@ -2539,6 +2607,8 @@ void hostlist_uniq(hostlist_t hl)
 		return;
 	}
 	qsort(hl->hr, hl->nranges, sizeof(hostrange_t), &_cmp);
+	hl->sorted = HOSTLIST_SORT_UNKNOWN;
+	_hostlist_clear_offsets(hl);
 
 	while (i < hl->nranges) {
 		if (_attempt_range_join(hl, i) < 0) /* No range join occurred */
@@ -2552,6 +2622,110 @@ void hostlist_uniq(hostlist_t hl)
 	UNLOCK_HOSTLIST(hl);
 }
 
+/* Return true if hostrange cur may follow hostrange prev (NULL if cur is
+ * the first range) in a hostlist searched by _hostlist_bsearch(): cur's
+ * prefix may not end in a digit (see the leading zero handling in
+ * hostrange_hn_within()), prev's prefix must sort before cur's and if
+ * the prefixes match then prev must be a singlehost or end before cur
+ */
+static int _hostrange_searchable(hostrange_t prev, hostrange_t cur)
+{
+	int len = strlen(cur->prefix), rc;
+
+	if (len && isdigit((int)cur->prefix[len - 1]))
+		return 0;
+	if (prev == NULL)
+		return 1;
+	if ((rc = strnatcmp(prev->prefix, cur->prefix)))
+		return (rc < 0);
+	if (strcmp(prev->prefix, cur->prefix) || cur->singlehost)
+		return 0;
+	return (prev->singlehost || (prev->hi < cur->lo));
+}
+
+/* Return true if the ranges of hostlist hl may be binary searched,
+ * checking them again if they were reordered since the last call.
+ * Assumes that the caller has the hostlist hl locked
+ */
+static int _hostlist_sorted(hostlist_t hl)
+{
+	int i;
+
+	if (hl->sorted == HOSTLIST_SORT_UNKNOWN) {
+		hl->sorted = HOSTLIST_SORTED;
+		for (i = 0; i < hl->nranges; i++) {
+			if (!_hostrange_searchable(i ? hl->hr[i - 1] : NULL,
+						   hl->hr[i])) {
+				hl->sorted = HOSTLIST_UNSORTED;
+				break;
+			}
+		}
+	}
+
+	return (hl->sorted == HOSTLIST_SORTED);
+}
+
+/* Return an array holding the number of hosts in the ranges before each
+ * range of hostlist hl, cached until hl changes.
+ * Assumes that the caller has the hostlist hl locked
+ */
+static int *_hostlist_offsets(hostlist_t hl)
+{
+	int i, count = 0;
+
+	if (hl->offset == NULL) {
+		if (!(hl->offset = malloc(hl->nranges * sizeof(int))))
+			out_of_memory("hostlist offsets");
+		for (i = 0; i < hl->nranges; i++) {
+			hl->offset[i] = count;
+			count += hostrange_count(hl->hr[i]);
+		}
+	}
+
+	return hl->offset;
+}
+
+/* Discard the range offsets cached by _hostlist_offset()
+ * Assumes that the caller has the hostlist hl locked
+ */
+static void _hostlist_clear_offsets(hostlist_t hl)
+{
+	if (hl->offset) {
+		free(hl->offset);
+		hl->offset = NULL;
+	}
+}
+
+/* Binary search the sorted hostlist hl for the range containing hostname
+ * hn, which must have a valid numeric suffix.
+ * Returns the index of the range or -1 if hn is not in hl.
+ * Assumes that the caller has the hostlist hl locked
+ */
+static int _hostlist_bsearch(hostlist_t hl, hostname_t hn)
+{
+	int lo = 0, hi = hl->nranges - 1, mid, rc;
+	hostrange_t hr;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		hr = hl->hr[mid];
+		if ((rc = strnatcmp(hr->prefix, hn->prefix)) == 0) {
+			if (hr->singlehost || (hr->hi < hn->num))
+				rc = -1;
+			else if (hr->lo > hn->num)
+				rc = 1;
+			else
+				return hostrange_hn_within(hr, hn) ? mid : -1;
+		}
+		if (rc < 0)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	return -1;
+}
+
 char *hostlist_deranged_string_malloc(hostlist_t hl)
 {
 	int buf_size = 8192;
@@ -3455,6 +3629,7 @@ int hostlist_remove(hostlist_iterator_t i)
 	assert(i != NULL);
 	assert(i->magic == HOSTLIST_MAGIC);
 	LOCK_HOSTLIST(i->hl);
+	_hostlist_clear_offsets(i->hl);
 	new = hostrange_delete_host(i->hr, i->hr->lo + i->depth);
 	if (new) {
 		hostlist_insert_range(i->hl, new, i->idx + 1);
@@ -3538,6 +3713,9 @@ static int hostset_insert_range(hostset_t set, hostrange_t hr)
 	if (hl->size == hl->nranges && !hostlist_expand(hl))
 		return 0;
 
+	hl->sorted = HOSTLIST_SORT_UNKNOWN;
+	_hostlist_clear_offsets(hl);
+
 	nhosts = hostrange_count(hr);
 
 	for (i = 0; i < hl->nranges; i++) {
@@ -3594,7 +3772,8 @@ int hostset_insert(hostset_t set, const char *hosts)
 }
 
 
-/* linear search through N ranges for hostname "host"
+/* search through N ranges for hostname "host", binary if the ranges
+ * are sorted, linear otherwise
  * */
 static int hostset_find_host(hostset_t set, const char *host)
 {
@@ -3603,6 +3782,10 @@ static int hostset_find_host(hostset_t set, const char *host)
 	hostname_t hn;
 	LOCK_HOSTLIST(set->hl);
 	hn = hostname_create(host);
+	if (hostname_suffix_is_valid(hn) && _hostlist_sorted(set->hl)) {
+		retval = (_hostlist_bsearch(set->hl, hn) >= 0);
+		goto done;
+	}
 	for (i = 0; i < set->hl->nranges; i++) {
 		if (hostrange_hn_within(set->hl->hr[i], hn)) {
 			retval = 1;
@@ -3772,6 +3955,56 @@ int iterator_test(char *list)
 	return 1;
 }
 
+/* time hostlist_find() and hostlist_delete_host() on a list of nhosts hosts
+ * made of ranges of two hosts each, i.e. node[0-1,3-4,6-7,...]
+ */
+int find_test(int nhosts)
+{
+	int i, pos, found = 0, errors = 0;
+	char host[64];
+	hostlist_t hl = hostlist_create(NULL);
+	DEF_TIMERS;
+
+	for (i = 0; found < nhosts; i++) {
+		if ((i % 3) == 2)
+			continue;
+		snprintf(host, sizeof(host), "node%d", i);
+		hostlist_push_host(hl, host);
+		found++;
+	}
+
+	START_TIMER;
+	for (i = 0, pos = 0; pos < nhosts; i++) {
+		snprintf(host, sizeof(host), "node%d", i);
+		if ((i % 3) == 2) {
+			if (hostlist_find(hl, host) != -1)
+				errors++;
+			continue;
+		}
+		if (hostlist_find(hl, host) != pos++)
+			errors++;
+	}
+	END_TIMER;
+	printf("find_test: %d hosts in %d ranges, hostlist_find %s\n",
+	       nhosts, hostlist_nranges(hl), TIME_STR);
+
+	hostlist_uniq(hl);
+	START_TIMER;
+	for (i = nhosts - 1; i >= 0; i -= 2) {
+		snprintf(host, sizeof(host), "node%d", (i / 2) * 3 + (i % 2));
+		if (hostlist_delete_host(hl, host) != 1)
+			errors++;
+	}
+	END_TIMER;
+	printf("find_test: hostlist_delete_host %s, %d hosts left\n",
+	       TIME_STR, hostlist_count(hl));
+
+	hostlist_destroy(hl);
+	if (errors)
+		printf("find_test: %d errors\n", errors);
+	return (errors == 0);
+}
+
 int main(int ac, char **av)
 {
 	char buf[1024000];
@@ -3827,6 +4060,7 @@ int main(int ac, char **av)
 	printf("ranged   = `%s'\n", buf);
 
 	iterator_test(buf);
+	find_test(100000);
 
 	hostlist_deranged_string(hl1, 10240, buf);
 	printf("deranged = `%s'\n", buf);
@@ -90,6 +90,12 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/* Displacements of the perfect hash over node names built by rehash_node(),
+ * NULL if node_hash_table uses the chained _hash_index() instead */
+static uint32_t *node_hash_disp = NULL;
+static int node_hash_buckets = 0;	/* size of node_hash_disp */
+static int node_hash_size = 0;		/* size of node_hash_table */
+
 static void	_add_config_feature(char *feature, bitstr_t *node_bitmap);
 static int	_build_single_nodeline_info(slurm_conf_node_t *node_ptr,
 					    struct config_record *config_ptr);
@@ -99,6 +105,10 @@ static void	_dump_hash (void);
 #endif
 static struct node_record *_find_alias_node_record (char *name);
 static int	_hash_index (char *name);
+static uint64_t	_hash_name (char *name);
+static int	_hash_slot (uint64_t hash, uint32_t disp);
+static bool	_build_perfect_hash (void);
+static void	_free_perfect_hash (void);
 static void	_list_delete_config (void *config_entry);
 static void	_list_delete_feature (void *feature_entry);
 static int	_list_find_config (void *config_entry, void *key);
@@ -418,6 +428,13 @@ static int _hash_index (char *name)
 	    (name == NULL))
 		return 0;	/* degenerate case */
 
+	if (node_hash_disp) {
+		uint64_t hash = _hash_name(name);
+		return _hash_slot(hash,
+				  node_hash_disp[(hash >> 32) %
+						 node_hash_buckets]);
+	}
+
 	/* Multiply each character by its numerical position in the
 	 * name string to add a bit of entropy, because host names such
 	 * as cluster[0001-1000] can cause excessive index collisions.
@@ -431,6 +448,161 @@ static int _hash_index (char *name)
 	return index;
 }
 
+/*
+ * _hash_name - return a 64-bit hash of a node name (FNV-1a, with a final
+ *	mix so that names differing only in their last digits also differ
+ *	in the high order bits)
+ */
+static uint64_t _hash_name (char *name)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for ( ; *name; name++) {
+		hash ^= (unsigned char) *name;
+		hash *= 1099511628211ULL;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+/*
+ * _hash_slot - return the node_hash_table index of a name with the given
+ *	hash when its bucket has displacement disp
+ */
+static int _hash_slot (uint64_t hash, uint32_t disp)
+{
+	uint64_t h1 = hash & 0xffffffff, h2 = (hash >> 21) | 1;
+
+	return (int) ((h1 + (disp / node_hash_size) * h2 +
+		       (disp % node_hash_size)) % node_hash_size);
+}
+
+/*
+ * _build_perfect_hash - fill node_hash_table as a minimal perfect hash of
+ *	the node names. Names are put in buckets of about four by their hash.
+ *	Starting with the largest bucket, a displacement is then found for
+ *	each bucket which puts all of its names into free table slots, so a
+ *	lookup is one hash computation and one string compare.
+ * RET true on success, false if no displacement could be found for some
+ *	bucket (e.g. duplicate node names), node_hash_table is then empty
+ */
+static bool _build_perfect_hash (void)
+{
+	struct node_record *node_ptr;
+	uint64_t *hash;
+	int *name_inx, *bucket_start, *bucket_order, *bucket_name;
+	int i, j, k, b, name_cnt = 0, max_cnt = 0, order_cnt = 0;
+	uint32_t disp, max_disp;
+	bitstr_t *slot_used;
+	bool rc = true;
+
+	_free_perfect_hash();
+	if (node_record_count == 0)
+		return false;
+
+	hash = xmalloc(sizeof(uint64_t) * node_record_count);
+	name_inx = xmalloc(sizeof(int) * node_record_count);
+	node_ptr = node_record_table_ptr;
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		if ((node_ptr->name == NULL) ||
+		    (node_ptr->name[0] == '\0'))
+			continue;	/* vestigial record */
+		hash[name_cnt] = _hash_name(node_ptr->name);
+		name_inx[name_cnt++] = i;
+	}
+
+	/* Sort the names by bucket, then the buckets by decreasing size */
+	node_hash_buckets = name_cnt / 4 + 1;
+	node_hash_size = node_record_count;
+	node_hash_disp = xmalloc(sizeof(uint32_t) * node_hash_buckets);
+	bucket_start = xmalloc(sizeof(int) * (node_hash_buckets + 1));
+	for (j = 0; j < name_cnt; j++)
+		bucket_start[(hash[j] >> 32) % node_hash_buckets + 1]++;
+	for (b = 0; b < node_hash_buckets; b++) {
+		max_cnt = MAX(max_cnt, bucket_start[b + 1]);
+		bucket_start[b + 1] += bucket_start[b];
+	}
+	bucket_name = xmalloc(sizeof(int) * name_cnt);
+	for (j = 0; j < name_cnt; j++) {
+		b = (hash[j] >> 32) % node_hash_buckets;
+		bucket_name[bucket_start[b]++] = j;
+	}
+	for (b = node_hash_buckets; b > 0; b--)
+		bucket_start[b] = bucket_start[b - 1];
+	bucket_start[0] = 0;
+	bucket_order = xmalloc(sizeof(int) * node_hash_buckets);
+	for (k = max_cnt; k > 0; k--) {
+		for (b = 0; b < node_hash_buckets; b++) {
+			if ((bucket_start[b + 1] - bucket_start[b]) == k)
+				bucket_order[order_cnt++] = b;
+		}
+	}
+
+	slot_used = bit_alloc(node_hash_size);
+	max_disp = (uint32_t) node_hash_size * 64;
+	for (i = 0; i < order_cnt; i++) {
+		int first, last;
+		b = bucket_order[i];
+		first = bucket_start[b];
+		last = bucket_start[b + 1];
+		for (disp = 0; disp < max_disp; disp++) {
+			for (j = first; j < last; j++) {
+				int inx = _hash_slot(hash[bucket_name[j]], disp);
+				if (bit_test(slot_used, inx))
+					break;
+				for (k = first; k < j; k++) {
+					if (_hash_slot(hash[bucket_name[k]], disp)
+					    == inx)
+						break;
+				}
+				if (k < j)
+					break;
+			}
+			if (j == last)
+				break;
+		}
+		if (disp == max_disp) {
+			rc = false;
+			break;
+		}
+		node_hash_disp[b] = disp;
+		for (j = first; j < last; j++) {
+			node_ptr = node_record_table_ptr + name_inx[bucket_name[j]];
+			k = _hash_slot(hash[bucket_name[j]], disp);
+			bit_set(slot_used, k);
+			node_ptr->node_next = NULL;
+			node_hash_table[k] = node_ptr;
+		}
+	}
+
+	if (!rc) {
+		debug("rehash_node: no perfect hash for %d node names, "
+		      "using chained hash", name_cnt);
+		memset(node_hash_table, 0,
+		       sizeof(struct node_record *) * node_record_count);
+		_free_perfect_hash();
+	}
+	FREE_NULL_BITMAP(slot_used);
+	xfree(bucket_order);
+	xfree(bucket_start);
+	xfree(hash);
+	xfree(bucket_name);
+	xfree(name_inx);
+
+	return rc;
+}
+
+/* _free_perfect_hash - revert _hash_index() to the chained hash */
+static void _free_perfect_hash (void)
+{
+	xfree(node_hash_disp);
+	node_hash_buckets = 0;
+	node_hash_size = 0;
+}
+
 /* _list_delete_config - delete an entry from the config list,
  *	see list.h for documentation */
 static void _list_delete_config (void *config_entry)
@@ -838,6 +1010,27 @@ extern struct node_record *find_node_record (char *name)
 }
 
 
+/*
+ * find_node_record_after - find a record for node with specified name,
+ *	first checking the record after prev. Consecutive names of a
+ *	hostlist range are usually consecutive node records, so this
+ *	converts a range without any hash lookups.
+ * IN prev - record found for the previous name in the list or NULL
+ * IN name - name of the desired node
+ * RET pointer to node record or NULL if not found
+ */
+extern struct node_record *find_node_record_after (struct node_record *prev,
+						   char *name)
+{
+	if (prev && name &&
+	    (++prev < (node_record_table_ptr + node_record_count)) &&
+	    prev->name && !strcmp(prev->name, name))
+		return prev;
+
+	return find_node_record(name);
+}
+
+
 /*
  * init_node_conf - initialize the node configuration tables and values.
  *	this should be called before creating any node or configuration
@@ -857,6 +1050,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xfree(node_hash_table);
+	_free_perfect_hash();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -891,6 +1085,7 @@ extern void node_fini2 (void)
 
 	xfree(node_record_table_ptr);
 	xfree(node_hash_table);
+	_free_perfect_hash();
 	node_record_count = 0;
 }
 
@@ -911,6 +1106,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
+	struct node_record *node_ptr = NULL;
 
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
@@ -929,8 +1125,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 	}
 
 	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		struct node_record *node_ptr;
-		node_ptr = find_node_record (this_node_name);
+		node_ptr = find_node_record_after (node_ptr, this_node_name);
 		if (node_ptr) {
 			bit_set (my_bitmap, (bitoff_t) (node_ptr -
 							node_record_table_ptr));
@@ -980,6 +1175,9 @@ extern void rehash_node (void)
 	node_hash_table = xmalloc (sizeof (struct node_record *) *
 				   node_record_count);
 
+	if (_build_perfect_hash())
+		goto fini;
+
 	for (i = 0; i < node_record_count; i++, node_ptr++) {
 		if ((node_ptr->name == NULL) ||
 		    (node_ptr->name[0] == '\0'))
@@ -989,6 +1187,7 @@ extern void rehash_node (void)
 		node_hash_table[inx] = node_ptr;
 	}
 
+fini:
 #if _DEBUG
 	_dump_hash();
 #endif
@@ -238,6 +238,17 @@ extern struct node_record *create_node_record (
  */
 extern struct node_record *find_node_record (char *name);
 
+/*
+ * find_node_record_after - find a record for node with specified name,
+ *	first checking the record after prev, which is a hit for names
+ *	from the same hostlist range
+ * IN prev - record found for the previous name in the list or NULL
+ * IN name - name of the desired node
+ * RET pointer to node record or NULL if not found
+ */
+extern struct node_record *find_node_record_after (struct node_record *prev,
+						   char *name);
+
 /*
  * init_node_conf - initialize the node configuration tables and values.
  *	this should be called before creating any node or configuration
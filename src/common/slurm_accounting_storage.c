@@ -73,6 +73,7 @@ typedef struct slurm_acct_storage_ops {
 				    char *cluster_name);
 	int  (*close_conn)         (void **db_conn);
 	int  (*commit)             (void *db_conn, bool commit);
+	int  (*batch)              (void *db_conn, bool start);
 	int  (*add_users)          (void *db_conn, uint32_t uid,
 				    List user_list);
 	int  (*add_coord)          (void *db_conn, uint32_t uid,
@@ -198,6 +199,7 @@ static const char *syms[] = {
 	"acct_storage_p_get_connection",
 	"acct_storage_p_close_connection",
 	"acct_storage_p_commit",
+	"acct_storage_p_batch",
 	"acct_storage_p_add_users",
 	"acct_storage_p_add_coord",
 	"acct_storage_p_add_accts",
@@ -335,6 +337,14 @@ extern int acct_storage_g_commit(void *db_conn, bool commit)
 
 }
 
+extern int acct_storage_g_batch(void *db_conn, bool start)
+{
+	if (slurm_acct_storage_init(NULL) < 0)
+		return SLURM_ERROR;
+	return (*(ops.batch))(db_conn, start);
+
+}
+
 extern int acct_storage_g_add_users(void *db_conn, uint32_t uid,
 				    List user_list)
 {
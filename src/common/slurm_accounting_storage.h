@@ -82,6 +82,18 @@ extern int acct_storage_g_close_connection(void **db_conn);
  */
 extern int acct_storage_g_commit(void *db_conn, bool commit);
 
+/*
+ * group the records written on a connection that was not opened with
+ * rollback into a single transaction
+ * IN: void * pointer returned from acct_storage_g_get_connection()
+ * IN: bool - true starts the batch false stores it
+ * RET: SLURM_SUCCESS on success SLURM_ERROR else, if storing the batch
+ *      fails none of it was kept
+ * NOTE: updates committed with acct_storage_g_commit() during the batch
+ *       are only sent out once the batch is stored
+ */
+extern int acct_storage_g_batch(void *db_conn, bool start);
+
 /*
  * add users to accounting system
  * IN:  user_list List of slurmdb_user_rec_t *
@@ -91,6 +91,8 @@ static int message_timeout = -1;
 static char *_global_auth_key(void);
 static void  _remap_slurmctld_errno(void);
 static int   _unpack_msg_uid(Buf buffer);
+static int   _send_buffer(slurm_fd_t fd, slurm_msg_t *msg, Buf buffer);
+static int   _send_packed_msg(slurm_fd_t fd, slurm_msg_t *msg);
 
 #if _DEBUG
 static void _print_data(char *data, int len);
@@ -2763,6 +2765,9 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	int      rc;
 	void *   auth_cred;
 
+	if (msg->packed)
+		return _send_packed_msg(fd, msg);
+
 	/*
 	 * Initialize header with Auth credential and message type.
 	 */
@@ -2813,6 +2818,18 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	/*
 	 * Send message
 	 */
+	return _send_buffer(fd, msg, buffer);
+}
+
+/*
+ *  Send a packed message in buffer over an open file descriptor `fd'
+ *    and free the buffer.
+ *    Returns the size of the message sent in bytes, or -1 on failure.
+ */
+static int _send_buffer(slurm_fd_t fd, slurm_msg_t *msg, Buf buffer)
+{
+	int rc;
+
 	rc = _slurm_msg_sendto( fd, get_buf_data(buffer),
 				get_buf_offset(buffer),
 				SLURM_PROTOCOL_NO_SEND_RECV_FLAGS );
@@ -2834,6 +2851,75 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	return rc;
 }
 
+/*
+ *  Same as slurm_send_node_msg(), but send the auth credential and body
+ *    previously packed into msg->packed by slurm_pack_msg_body()
+ */
+static int _send_packed_msg(slurm_fd_t fd, slurm_msg_t *msg)
+{
+	header_t header;
+	Buf      buffer;
+	uint32_t packed_len = get_buf_offset(msg->packed);
+
+	if (msg->forward.init != FORWARD_INIT) {
+		forward_init(&msg->forward, NULL);
+		msg->ret_list = NULL;
+	}
+	forward_wait(msg);
+
+	init_header(&header, msg, msg->flags);
+	update_header(&header, msg->packed_body_len);
+
+	buffer = init_buf(BUF_SIZE + packed_len);
+	pack_header(&header, buffer);
+	if (remaining_buf(buffer) < packed_len) {
+		buffer->size += (packed_len + BUF_SIZE);
+		xrealloc(buffer->head, buffer->size);
+	}
+	memcpy(&buffer->head[buffer->processed],
+	       get_buf_data(msg->packed), packed_len);
+	buffer->processed += packed_len;
+
+	return _send_buffer(fd, msg, buffer);
+}
+
+int slurm_pack_msg_body(slurm_msg_t *msg)
+{
+	header_t header;
+	void *   auth_cred;
+	uint32_t auth_len;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY)
+		auth_cred = g_slurm_auth_create(NULL, 2, _global_auth_key());
+	else
+		auth_cred = g_slurm_auth_create(NULL, 2, NULL);
+	if (auth_cred == NULL) {
+		error("authentication: %s",
+		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
+		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+	}
+
+	/* sets msg->protocol_version used by pack_msg() */
+	init_header(&header, msg, msg->flags);
+
+	msg->packed = init_buf(BUF_SIZE);
+	if (g_slurm_auth_pack(auth_cred, msg->packed)) {
+		error("authentication: %s",
+		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(msg->packed);
+		msg->packed = NULL;
+		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+	}
+	(void) g_slurm_auth_destroy(auth_cred);
+
+	auth_len = get_buf_offset(msg->packed);
+	pack_msg(msg, msg->packed);
+	msg->packed_body_len = get_buf_offset(msg->packed) - auth_len;
+
+	return SLURM_SUCCESS;
+}
+
 /**********************************************************************\
  * stream functions
 \**********************************************************************/
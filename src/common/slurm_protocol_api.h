@@ -760,6 +760,17 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
  */
 int slurm_send_node_msg(slurm_fd_t open_fd, slurm_msg_t *msg);
 
+/* packs the auth credential and body of a message once, so that it can be
+ * sent to many nodes without creating a credential and packing the data
+ * for each of them
+ *
+ * IN/OUT msg		- a slurm msg struct, msg->packed and
+ *			  msg->packed_body_len are set on success
+ * RET int		- SLURM_SUCCESS or SLURM_ERROR with errno set
+ * NOTE: the caller must free_buf() msg->packed when no longer needed
+ */
+int slurm_pack_msg_body(slurm_msg_t *msg);
+
 /**********************************************************************\
  * msg connection establishment functions used by msg clients
 \**********************************************************************/
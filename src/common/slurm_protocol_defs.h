@@ -408,6 +408,10 @@ typedef struct slurm_msg {
 	forward_struct_t *forward_struct;
 	slurm_addr_t orig_addr;
 	List ret_list;
+	/* If set, the auth credential and body packed by slurm_pack_msg_body()
+	 * are sent instead of packing data again (not freed with the msg) */
+	Buf packed;
+	uint32_t packed_body_len;	/* length of the body within packed */
 } slurm_msg_t;
 
 typedef struct ret_data_info {
@@ -50,6 +50,7 @@
 /* defined here but is really tree plugin related */
 struct switch_record *switch_record_table = NULL;
 int switch_record_cnt = 0;
+int switch_levels = 0;
 
 /* ************************************************************************ */
 /*  TAG(                        slurm_topo_ops_t                         )  */
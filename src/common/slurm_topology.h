@@ -54,10 +54,16 @@ struct switch_record {
 					 * this switch */
 	char *nodes;			/* name if direct descendent nodes */
 	char *switches;			/* name if direct descendent switches */
+	uint16_t parent;		/* index of parent switch, NO_VAL if
+					 * this is a top level switch */
+	uint16_t num_switches;		/* count of direct descendent switches */
+	uint16_t *switch_index;		/* indexes of direct descendent
+					 * switches in switch_record_table */
 };
 
 extern struct switch_record *switch_record_table;  /* ptr to switch records */
 extern int switch_record_cnt;		/* size of switch_record_table */
+extern int switch_levels;		/* number of switch levels */
 
 /*****************************************************************************\
  *  Slurm topology functions
@@ -85,6 +85,8 @@ strong_alias(slurmdbd_free_id_rc_msg,	slurmdb_slurmdbd_free_id_rc_msg);
 
 #define DBD_MAGIC		0xDEAD3219
 #define MAX_AGENT_QUEUE		10000
+#define DBD_AGENT_BATCH		1000	/* Records per DBD_SEND_MULT_MSG */
+#define DBD_AGENT_WINDOW	4	/* DBD_SEND_MULT_MSG in flight */
 #define MAX_DBD_MSG_LEN		16384
 #define SLURMDBD_TIMEOUT	900	/* Seconds SlurmDBD for response */
 
@@ -109,6 +111,8 @@ static slurm_trigger_callbacks_t callback;
 static bool      callbacks_requested = 0;
 static bool      from_ctld           = 0;
 static bool      need_to_register    = 0;
+static uint32_t  mult_msg_seq        = 1;	/* next batch number */
+static bool      mult_msg_seq_ok     = 0;	/* slurmdbd echoes it */
 
 static void * _agent(void *x);
 static void   _close_slurmdbd_fd(void);
@@ -126,7 +130,10 @@ static int    _save_dbd_rec(int fd, Buf buffer);
 static void   _save_dbd_state(void);
 static int    _send_init_msg(void);
 static int    _send_fini_msg(void);
-static int    _send_msg(Buf buffer);
+static int    _send_msg(Buf buffer, bool reopen);
+static List   _agent_batch(ListIterator agent_itr);
+static int    _agent_pack_batches(int window, Buf *batch_buf,
+				  int *batch_cnt, uint32_t *batch_seq);
 static void   _sig_handler(int signal);
 static void   _shutdown_agent(void);
 static void   _slurmdbd_packstr(void *str, uint16_t rpc_version, Buf buffer);
@@ -328,7 +335,7 @@ extern int slurm_send_recv_slurmdbd_msg(uint16_t rpc_version,
 		goto end_it;
 	}
 
-	rc = _send_msg(buffer);
+	rc = _send_msg(buffer, 1);
 	free_buf(buffer);
 	if (rc != SLURM_SUCCESS) {
 		error("slurmdbd: Sending message type %u: %d: %m",
@@ -460,6 +467,8 @@ again:
 		} else {
 			int rc;
 			fd_set_nonblocking(slurmdbd_fd);
+			/* batch numbers are tracked per connection */
+			mult_msg_seq_ok = 0;
 			rc = _send_init_msg();
 			if (rc == SLURM_SUCCESS) {
 				if (from_ctld)
@@ -1500,7 +1509,7 @@ static int _send_init_msg()
 	   but send anyway so we get it logged on the slurmdbd also */
 	tmp_errno = errno;
 
-	rc = _send_msg(buffer);
+	rc = _send_msg(buffer, 1);
 	free_buf(buffer);
 	if (rc != SLURM_SUCCESS) {
 		error("slurmdbd: Sending DBD_INIT message: %d: %m", rc);
@@ -1532,7 +1541,7 @@ static int _send_fini_msg(void)
 	req.close_conn   = 1;
 	slurmdbd_pack_fini_msg(&req, SLURMDBD_VERSION, buffer);
 
-	_send_msg(buffer);
+	_send_msg(buffer, 1);
 	free_buf(buffer);
 
 	return SLURM_SUCCESS;
@@ -1555,7 +1564,11 @@ static void _reopen_slurmdbd_fd(void)
 	_open_slurmdbd_fd(1);
 }
 
-static int _send_msg(Buf buffer)
+/* Write a packed message to the SlurmDBD. If reopen is set a connection
+ * the DBD has hung up on is reopened and the write retried, otherwise
+ * EAGAIN is returned so the caller can tell the message never went out
+ * on the connection it expects a reply from. */
+static int _send_msg(Buf buffer, bool reopen)
 {
 	uint32_t msg_size, nw_size;
 	char *msg;
@@ -1568,7 +1581,7 @@ static int _send_msg(Buf buffer)
 	rc =_fd_writeable(slurmdbd_fd);
 	if (rc == -1) {
 	re_open:	/* SlurmDBD shutdown, try to reopen a connection now */
-		if (retry_cnt++ > 3)
+		if (!reopen || (retry_cnt++ > 3))
 			return EAGAIN;
 		/* if errno is ACCESS_DENIED do not try to reopen to
 		   connection just return that */
@@ -1678,7 +1691,12 @@ static int _get_return_code(uint16_t rpc_version, int read_timeout)
 	return rc;
 }
 
-static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
+/* Read the reply to DBD_SEND_MULT_MSG batch number seq and dequeue one
+ * agent_list entry per successful return code.  The number of entries
+ * dequeued is returned in ack_cnt, which is -1 if no reply to this batch
+ * could be read. */
+static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout,
+			       uint32_t seq, int *ack_cnt)
 {
 	Buf buffer;
 	uint16_t msg_type;
@@ -1687,6 +1705,7 @@ static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
 	int rc = SLURM_ERROR;
 	Buf out_buf = NULL;
 
+	*ack_cnt = -1;
 	buffer = _recv_msg(read_timeout);
 	if (buffer == NULL)
 		return rc;
@@ -1701,6 +1720,19 @@ static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
 			break;
 		}
 
+		/* A slurmdbd that does not echo the batch number stores
+		 * batches without checking their order, so only one is
+		 * sent to it at a time. */
+		if (list_msg->return_code == seq)
+			mult_msg_seq_ok = 1;
+		else if (mult_msg_seq_ok) {
+			error("slurmdbd: DBD_GOT_MULT_MSG for batch %u, "
+			      "expected batch %u", list_msg->return_code, seq);
+			slurmdbd_free_list_msg(list_msg);
+			break;
+		}
+
+		*ack_cnt = 0;
 		slurm_mutex_lock(&agent_lock);
 		if (agent_list) {
 			ListIterator itr =
@@ -1714,6 +1746,7 @@ static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
 
 				if ((b = list_dequeue(agent_list))) {
 					free_buf(b);
+					(*ack_cnt)++;
 				} else {
 					error("slurmdbd: DBD_GOT_MULT_MSG "
 					      "unpack message error");
@@ -1727,6 +1760,7 @@ static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
 	case DBD_RC:
 		if (slurmdbd_unpack_rc_msg(&msg, rpc_version, buffer)
 		    == SLURM_SUCCESS) {
+			*ack_cnt = 0;
 			rc = msg->return_code;
 			if (rc != SLURM_SUCCESS) {
 				if (msg->sent_type == DBD_REGISTER_CTLD &&
@@ -1905,9 +1939,11 @@ static int _fd_writeable(slurm_fd_t fd)
 		 * If not then exit out and notify the sender.  This
  		 * is here since a write doesn't always tell you the
 		 * socket is gone, but getting 0 back from a
-		 * nonblocking read means just that.
+		 * nonblocking read means just that. Only peek, as
+		 * replies to batches already sent may be waiting.
 		 */
-		if (ufds.revents & POLLHUP || (recv(fd, &temp, 1, 0) == 0)) {
+		if (ufds.revents & POLLHUP ||
+		    (recv(fd, &temp, 1, MSG_PEEK) == 0)) {
 			debug2("SlurmDBD connection is closed");
 			if (callbacks_requested)
 				(callback.dbd_fail)();
@@ -1999,20 +2035,130 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void *_agent(void *x)
+/* Collect the next DBD_AGENT_BATCH records of agent_list into a list to
+ * be sent as one DBD_SEND_MULT_MSG. The records stay on agent_list until
+ * the slurmdbd acknowledges them. */
+static List _agent_batch(ListIterator agent_itr)
 {
-	int cnt, rc;
+	List batch = list_create(NULL);
 	Buf buffer;
-	struct timespec abs_time;
-	static time_t fail_time = 0;
-	int sigarray[] = {SIGUSR1, 0};
-	int read_timeout = SLURMDBD_TIMEOUT * 1000;
+	int batch_cnt = 0;
+
+	while ((batch_cnt < DBD_AGENT_BATCH) &&
+	       (buffer = list_next(agent_itr))) {
+		list_enqueue(batch, buffer);
+		batch_cnt++;
+	}
+	return batch;
+}
+
+static uint32_t _next_mult_msg_seq(uint32_t seq)
+{
+	/* 0 means a batch is not numbered */
+	if (++seq == 0)
+		seq = 1;
+	return seq;
+}
+
+/* Pack up to window DBD_SEND_MULT_MSG batches from the head of
+ * agent_list, numbered on from mult_msg_seq. The number of records in
+ * each is returned in batch_cnt and its number in batch_seq.
+ * RET the number of batches packed */
+static int _agent_pack_batches(int window, Buf *batch_buf,
+			       int *batch_cnt, uint32_t *batch_seq)
+{
 	slurmdbd_msg_t list_req;
 	dbd_list_msg_t list_msg;
+	ListIterator agent_itr;
+	uint32_t seq = mult_msg_seq;
+	int i;
 
 	list_req.msg_type = DBD_SEND_MULT_MSG;
 	list_req.data = &list_msg;
 	memset(&list_msg, 0, sizeof(dbd_list_msg_t));
+
+	agent_itr = list_iterator_create(agent_list);
+	for (i = 0; i < window; i++) {
+		list_msg.my_list = _agent_batch(agent_itr);
+		batch_cnt[i] = list_count(list_msg.my_list);
+		if (batch_cnt[i]) {
+			list_msg.return_code = batch_seq[i] = seq;
+			batch_buf[i] = pack_slurmdbd_msg(&list_req,
+							 SLURMDBD_VERSION);
+			seq = _next_mult_msg_seq(seq);
+		}
+		list_destroy(list_msg.my_list);
+		if (!batch_cnt[i])
+			break;
+	}
+	list_iterator_destroy(agent_itr);
+
+	return i;
+}
+
+/* Send the rest of the batches packed by _agent_pack_batches() once the
+ * first one is on its way, and read the replies to all of them in order.
+ * Once a batch is not stored completely the slurmdbd refuses the ones
+ * after it, so the records acknowledged are always the head of
+ * agent_list, and the next round starts over with what is left of that
+ * batch. RET SLURM_SUCCESS if every record was stored */
+static int _handle_mult_msg_window(int batch_num, Buf *batch_buf,
+				   int *batch_cnt, uint32_t *batch_seq,
+				   int read_timeout)
+{
+	int i, sent, ack_cnt, batch_rc, rc = SLURM_SUCCESS;
+	bool send_failed = false;
+
+	/* Only a connection the slurmdbd numbers batches on gets more
+	 * than one, so one that was just reopened gets only the first.
+	 * It is never reopened after that, as a new connection would
+	 * store a later batch ahead of the earlier ones. */
+	for (sent = 1; (sent < batch_num) && mult_msg_seq_ok; sent++) {
+		if (_send_msg(batch_buf[sent], 0) != SLURM_SUCCESS) {
+			send_failed = true;
+			break;
+		}
+	}
+
+	for (i = 0; i < sent; i++) {
+		batch_rc = _handle_mult_rc_ret(SLURMDBD_VERSION, read_timeout,
+					       batch_seq[i], &ack_cnt);
+		if (ack_cnt < 0) {
+			/* Whatever the slurmdbd made of this batch and
+			 * those after it, a new connection starts over */
+			_reopen_slurmdbd_fd();
+			return SLURM_ERROR;
+		}
+		if ((rc == SLURM_SUCCESS) &&
+		    ((batch_rc != SLURM_SUCCESS) ||
+		     (ack_cnt < batch_cnt[i]))) {
+			rc = (batch_rc != SLURM_SUCCESS) ?
+				batch_rc : SLURM_ERROR;
+			mult_msg_seq = batch_seq[i];
+		}
+	}
+	if (rc == SLURM_SUCCESS)
+		mult_msg_seq = _next_mult_msg_seq(batch_seq[sent - 1]);
+
+	/* A batch only partly written would garble the next message */
+	if (send_failed)
+		_reopen_slurmdbd_fd();
+
+	return rc;
+}
+
+static void *_agent(void *x)
+{
+	int cnt, rc, i, batch_num;
+	Buf buffer;
+	Buf batch_buf[DBD_AGENT_WINDOW];
+	int batch_cnt[DBD_AGENT_WINDOW];
+	uint32_t batch_seq[DBD_AGENT_WINDOW];
+	struct timespec abs_time;
+	static time_t fail_time = 0;
+	int sigarray[] = {SIGUSR1, 0};
+	int read_timeout = SLURMDBD_TIMEOUT * 1000;
+
 	/* DEF_TIMERS; */
 
 	/* Prepare to catch SIGUSR1 to interrupt pending
@@ -2051,26 +2197,16 @@ static void *_agent(void *x)
 		} else if ((cnt > 0) && ((cnt % 50) == 0))
 			info("slurmdbd: agent queue size %u", cnt);
 		/* Leave item on the queue until processing complete */
+		batch_num = 0;
 		if (agent_list) {
-			int handle_agent_count = 1000;
-			if (cnt > handle_agent_count) {
-				int agent_count = 0;
-				ListIterator agent_itr =
-					list_iterator_create(agent_list);
-				list_msg.my_list = list_create(NULL);
-				while ((buffer = list_next(agent_itr))) {
-					list_enqueue(list_msg.my_list, buffer);
-					agent_count++;
-					if (agent_count > handle_agent_count)
-						break;
-				}
-				list_iterator_destroy(agent_itr);
-				buffer = pack_slurmdbd_msg(&list_req,
-							   SLURMDBD_VERSION);
-			} else if (cnt > 1) {
-				list_msg.my_list = agent_list;
-				buffer = pack_slurmdbd_msg(&list_req,
-							   SLURMDBD_VERSION);
+			if (cnt > 1) {
+				/* Keep several batches in flight once the
+				 * slurmdbd has shown it checks their order */
+				batch_num = _agent_pack_batches(
+					(mult_msg_seq_ok ?
+					 DBD_AGENT_WINDOW : 1),
+					batch_buf, batch_cnt, batch_seq);
+				buffer = batch_buf[0];
 			} else
 				buffer = (Buf) list_peek(agent_list);
 		} else
@@ -2090,16 +2226,19 @@ static void *_agent(void *x)
 		/* NOTE: agent_lock is clear here, so we can add more
 		 * requests to the queue while waiting for this RPC to
 		 * complete. */
-		rc = _send_msg(buffer);
+		rc = _send_msg(buffer, 1);
 		if (rc != SLURM_SUCCESS) {
 			if (agent_shutdown) {
+				for (i = 0; i < batch_num; i++)
+					free_buf(batch_buf[i]);
 				slurm_mutex_unlock(&slurmdbd_lock);
 				break;
 			}
 			error("slurmdbd: Failure sending message: %d: %m", rc);
-		} else if (list_msg.my_list) {
-			rc = _handle_mult_rc_ret(SLURMDBD_VERSION,
-						 read_timeout);
+		} else if (batch_num) {
+			rc = _handle_mult_msg_window(batch_num, batch_buf,
+						     batch_cnt, batch_seq,
+						     read_timeout);
 		} else {
 			rc = _get_return_code(SLURMDBD_VERSION, read_timeout);
 			if (rc == EAGAIN) {
@@ -2119,33 +2258,22 @@ static void *_agent(void *x)
 
 		slurm_mutex_lock(&agent_lock);
 		if (agent_list && (rc == SLURM_SUCCESS)) {
-			/* If we sent a mult_msg we just need to free
-			   buffer, we don't need to requeue, just mark
-			   list_msg.my_list as NULL as that is the
-			   sign we sent a mult_msg.
+			/* The records of mult_msgs were dequeued as
+			   they were acknowledged, we just need to
+			   free the batches.
 			*/
-			if (list_msg.my_list) {
-				if (list_msg.my_list != agent_list)
-					list_destroy(list_msg.my_list);
-				list_msg.my_list = NULL;
-			} else
+			if (!batch_num) {
 				buffer = (Buf) list_dequeue(agent_list);
-
-			free_buf(buffer);
-			fail_time = 0;
-		} else {
-			/* We still need to free a mult_msg even if we
-			   got a failure.
-			*/
-			if(list_msg.my_list) {
-				if (list_msg.my_list != agent_list)
-					list_destroy(list_msg.my_list);
-				list_msg.my_list = NULL;
 				free_buf(buffer);
 			}
-
+			fail_time = 0;
+		} else
 			fail_time = time(NULL);
-		}
+		/* We still need to free the mult_msgs even if we
+		   got a failure.
+		*/
+		for (i = 0; i < batch_num; i++)
+			free_buf(batch_buf[i]);
 		slurm_mutex_unlock(&agent_lock);
 		/* END_TIMER; */
 		/* info("at the end with %s", TIME_STR); */
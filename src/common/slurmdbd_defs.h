@@ -316,7 +316,9 @@ typedef struct {
 				 * is handled correctly on both ends */
 	uint32_t return_code;   /* If there was an error and a list of
 				 * them this is the type of error it
-				 * was */
+				 * was, for DBD_SEND_MULT_MSG and
+				 * DBD_GOT_MULT_MSG the batch number
+				 * (0 if not numbered) */
 } dbd_list_msg_t;
 
 typedef struct {
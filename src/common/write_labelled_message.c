@@ -41,109 +41,79 @@
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "src/common/write_labelled_message.h"
+#include "src/common/fd.h"
 #include "slurm/slurm_errno.h"
 #include "src/common/log.h"
 
-static int _write_label(int fd, int taskid, int label_width);
+/* Number of labelled lines gathered into each writev() call */
+#define LABEL_IOV_LINES 64
+
 static int _write_line(int fd, void *buf, int len);
-static int _write_newline(int fd);
 
 
 
 int write_labelled_message(int fd, void *buf, int len, int taskid,
 			   bool label, int label_width)
 {
+	struct iovec iov[LABEL_IOV_LINES * 3];
+	char prefix[16];
+	int prefix_len;
 	void *start;
 	void *end;
 	int remaining = len;
 	int written = 0;
+	int pending = 0;
 	int line_len;
-	int rc = -1;
+	int cnt = 0;
+
+	if (len <= 0)
+		return -1;
+	if (!label)
+		return _write_line(fd, buf, len);
+
+	/* Every line of the message carries the same label, so build it
+	 * once and reference it from each line's iovec */
+	prefix_len = snprintf(prefix, sizeof(prefix), "%0*d: ",
+			      label_width, taskid);
+	if (prefix_len >= sizeof(prefix))
+		prefix_len = sizeof(prefix) - 1;
 
 	while (remaining > 0) {
-		start = buf + written;
+		start = buf + written + pending;
 		end = memchr(start, '\n', remaining);
-		if (label)
-			if (_write_label(fd, taskid, label_width)
-			    != SLURM_SUCCESS)
-				goto done;
+		iov[cnt].iov_base = prefix;
+		iov[cnt++].iov_len = prefix_len;
 		if (end == NULL) { /* no newline found */
-			rc = _write_line(fd, start, remaining);
-			if (rc <= 0) {
-				goto done;
-			} else {
-				remaining -= rc;
-				written += rc;
-			}
-			if (label)
-				if (_write_newline(fd) != SLURM_SUCCESS)
-					goto done;
+			line_len = remaining;
+			iov[cnt].iov_base = start;
+			iov[cnt++].iov_len = line_len;
+			iov[cnt].iov_base = "\n";
+			iov[cnt++].iov_len = 1;
 		} else {
 			line_len = (int)(end - start) + 1;
-			rc = _write_line(fd, start, line_len);
-			if (rc <= 0) {
-				goto done;
-			} else {
-				remaining -= rc;
-				written += rc;
-			}
+			iov[cnt].iov_base = start;
+			iov[cnt++].iov_len = line_len;
 		}
-
-	}
-done:
-	if (written > 0)
-		return written;
-	else
-		return rc;
-}
-
-
-static int _write_label(int fd, int taskid, int label_width)
-{
-	int n;
-	int left = label_width + 2;
-	char buf[16];
-	void *ptr = buf;
-
-	snprintf(buf, 16, "%0*d: ", label_width, taskid);
-	while (left > 0) {
-	again:
-		if ((n = write(fd, ptr, left)) < 0) {
-			if (errno == EINTR)
-				goto again;
-			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-				debug3("  got EAGAIN in _write_label");
-				goto again;
+		remaining -= line_len;
+		pending += line_len;
+
+		if ((remaining == 0) || (cnt + 3 > LABEL_IOV_LINES * 3)) {
+			/* Lines already written are not reported, the
+			 * caller gives up on the file after an error */
+			if (fd_writev_n(fd, iov, cnt) < 0) {
+				error("In write_labelled_message: %m");
+				return -1;
 			}
-			error("In _write_label: %m");
-			return SLURM_ERROR;
+			written += pending;
+			pending = 0;
+			cnt = 0;
 		}
-		left -= n;
-		ptr += n;
 	}
 
-	return SLURM_SUCCESS;
-}
-
-
-static int _write_newline(int fd)
-{
-	int n;
-
-	debug2("Called _write_newline");
-again:
-	if ((n = write(fd, "\n", 1)) < 0) {
-		if (errno == EINTR
-		    || errno == EAGAIN
-		    || errno == EWOULDBLOCK) {
-			goto again;
-		}
-		error("In _write_newline: %m");
-		return SLURM_ERROR;
-	}
-	return SLURM_SUCCESS;
+	return written;
 }
 
 
@@ -167,6 +137,7 @@ static int _write_line(int fd, void *buf, int len)
 				debug3("  got EAGAIN in _write_line");
 				goto again;
 			}
+			error("In _write_line: %m");
 			return -1;
 		}
 		left -= n;
@@ -50,9 +50,10 @@
  *               label for the task id
  * label_width is the number of digits to use for the task id
  *
- * Write as many lines from the message as possible.  Return
- * the number of bytes from the message that have been written,
- * or -1 on error.  If len==0, -1 will be returned.
+ * Write all lines of the message.  Return the number of bytes
+ * from the message that have been written, or -1 if any write
+ * failed, even after some lines went out.  If len==0, -1 will
+ * be returned.
  *
  * If the message ends in a partial line (line does not end
  * in a '\n'), then add a newline to the output file, but only
@@ -114,8 +114,9 @@ static MYSQL_RES *_get_last_result(MYSQL *db_conn)
 }
 
 /* NOTE: Insure that mysql_conn->lock is set on function entry */
-static int _mysql_query_internal(MYSQL *db_conn, char *query)
+static int _mysql_query_internal(mysql_conn_t *mysql_conn, char *query)
 {
+	MYSQL *db_conn = mysql_conn->db_conn;
 	int rc = SLURM_SUCCESS;
 
 	if (!db_conn)
@@ -134,6 +135,10 @@ static int _mysql_query_internal(MYSQL *db_conn, char *query)
 			goto end_it;
 		}
 		error("mysql_query failed: %d %s\n%s", errno, err_str, query);
+		/* A deadlock rolls back the whole transaction, not
+		 * just this statement */
+		if (errno == ER_LOCK_DEADLOCK)
+			mysql_conn->trans_lost = true;
 		if (errno == ER_LOCK_WAIT_TIMEOUT) {
 			fatal("mysql gave ER_LOCK_WAIT_TIMEOUT as an error. "
 			      "The only way to fix this is restart the "
@@ -625,7 +630,7 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 	if (!mysql_conn || !mysql_conn->db_conn)
 		fatal("You haven't inited this storage yet.");
 	slurm_mutex_lock(&mysql_conn->lock);
-	rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	rc = _mysql_query_internal(mysql_conn, query);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
@@ -694,7 +699,7 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if (_mysql_query_internal(mysql_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
 		else if (last)
@@ -718,8 +723,7 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if ((rc = _mysql_query_internal(
-		     mysql_conn->db_conn, query)) != SLURM_ERROR)
+	if ((rc = _mysql_query_internal(mysql_conn, query)) != SLURM_ERROR)
 		rc = _clear_results(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -730,7 +734,7 @@ extern int mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	int new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if (_mysql_query_internal(mysql_conn, query) != SLURM_ERROR)  {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
 			/* should have new id */
@@ -76,6 +76,8 @@ typedef struct {
 	pthread_mutex_t lock;
 	char *pre_commit_query;
 	bool rollback;
+	unsigned long batch_thread_id;
+	bool trans_lost; /* server rolled back the open transaction */
 	List update_list;
 	int conn;
 } mysql_conn_t;
@@ -118,6 +118,13 @@ const uint32_t plugin_version = 100;
 static mysql_db_info_t *mysql_db_info = NULL;
 static char *mysql_db_name = NULL;
 
+/* Closed connections kept open to the database for the next client instead
+ * of setting up a new MySQL session for every sacct or sreport run.
+ */
+#define MAX_IDLE_CONNS 10
+static List idle_conn_list = NULL;
+static pthread_mutex_t idle_conn_lock = PTHREAD_MUTEX_INITIALIZER;
+
 #define DELETE_SEC_BACK 86400
 
 char *acct_coord_table = "acct_coord_table";
@@ -792,7 +799,9 @@ extern int check_connection(mysql_conn_t *mysql_conn)
 					    "sql_mode='ANSI_QUOTES';");
 			if (rc != SLURM_SUCCESS) {
 				error("couldn't set sql_mode on reconnect");
-				acct_storage_p_close_connection(&mysql_conn);
+				/* drop the session so it is never reused,
+				 * the caller still owns mysql_conn */
+				mysql_db_close_db_connection(mysql_conn);
 				errno = ESLURM_DB_CONNECTION;
 				return ESLURM_DB_CONNECTION;
 			}
@@ -2133,6 +2142,12 @@ extern int fini ( void )
 	}
 	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
 	slurm_mutex_destroy(&as_mysql_cluster_list_lock);
+	slurm_mutex_lock(&idle_conn_lock);
+	if (idle_conn_list) {
+		list_destroy(idle_conn_list);
+		idle_conn_list = NULL;
+	}
+	slurm_mutex_unlock(&idle_conn_lock);
 	destroy_mysql_db_info(mysql_db_info);
 	xfree(mysql_db_name);
 	xfree(default_qos_str);
@@ -2140,6 +2155,84 @@ extern int fini ( void )
 	return SLURM_SUCCESS;
 }
 
+static void _destroy_idle_conn(void *object)
+{
+	destroy_mysql_conn((mysql_conn_t *)object);
+}
+
+/* Return an idle connection with the same rollback setting as requested,
+ * or NULL if there isn't a usable one.
+ */
+static mysql_conn_t *_get_idle_conn(int conn_num, bool rollback,
+				    char *cluster_name)
+{
+	mysql_conn_t *mysql_conn = NULL;
+	ListIterator itr;
+	unsigned long thread_id;
+
+	slurm_mutex_lock(&idle_conn_lock);
+	if (idle_conn_list) {
+		itr = list_iterator_create(idle_conn_list);
+		while ((mysql_conn = list_next(itr))) {
+			if (mysql_conn->rollback == rollback) {
+				list_remove(itr);
+				break;
+			}
+		}
+		list_iterator_destroy(itr);
+	}
+	slurm_mutex_unlock(&idle_conn_lock);
+
+	if (!mysql_conn)
+		return NULL;
+
+	/* this thread may not have used the client library yet */
+	if (mysql_thread_safe())
+		mysql_thread_init();
+
+	/* The server may have dropped the session while it was idle.
+	 * A silent reconnect would lose the session settings made when
+	 * the connection was opened, so only reuse the same session.
+	 */
+	thread_id = mysql_thread_id(mysql_conn->db_conn);
+	if (mysql_db_ping(mysql_conn)
+	    || (thread_id != mysql_thread_id(mysql_conn->db_conn))) {
+		destroy_mysql_conn(mysql_conn);
+		return NULL;
+	}
+
+	mysql_conn->conn = conn_num;
+	xfree(mysql_conn->cluster_name);
+	mysql_conn->cluster_name = xstrdup(cluster_name);
+	mysql_conn->cluster_deleted = 0;
+
+	return mysql_conn;
+}
+
+/* Keep a closed connection for reuse, RET true if it was kept */
+static bool _put_idle_conn(mysql_conn_t *mysql_conn)
+{
+	bool kept = false;
+
+	if (!mysql_conn->db_conn)
+		return false;
+
+	slurm_mutex_lock(&idle_conn_lock);
+	if (!idle_conn_list)
+		idle_conn_list = list_create(_destroy_idle_conn);
+	if (list_count(idle_conn_list) < MAX_IDLE_CONNS) {
+		list_append(idle_conn_list, mysql_conn);
+		kept = true;
+	}
+	slurm_mutex_unlock(&idle_conn_lock);
+
+	/* as mysql_db_close_db_connection() would have */
+	if (kept && mysql_thread_safe())
+		mysql_thread_end();
+
+	return kept;
+}
+
 extern void *acct_storage_p_get_connection(const slurm_trigger_callbacks_t *cb,
                                            int conn_num, bool rollback,
                                            char *cluster_name)
@@ -2152,6 +2245,11 @@ extern void *acct_storage_p_get_connection(const slurm_trigger_callbacks_t *cb,
 	debug2("acct_storage_p_get_connection: request new connection %d",
 	       rollback);
 
+	if ((mysql_conn = _get_idle_conn(conn_num, rollback, cluster_name))) {
+		errno = SLURM_SUCCESS;
+		return (void *)mysql_conn;
+	}
+
 	if (!(mysql_conn = create_mysql_conn(
 		      conn_num, rollback, cluster_name)))
 		fatal("couldn't get a mysql_conn");
@@ -2167,7 +2265,8 @@ extern void *acct_storage_p_get_connection(const slurm_trigger_callbacks_t *cb,
 				    "SET session sql_mode='ANSI_QUOTES';");
 		if (rc != SLURM_SUCCESS) {
 			error("couldn't set sql_mode");
-			acct_storage_p_close_connection(&mysql_conn);
+			destroy_mysql_conn(mysql_conn);
+			mysql_conn = NULL;
 			errno = rc;
 		} else
 			errno = SLURM_SUCCESS;
@@ -2184,7 +2283,10 @@ extern int acct_storage_p_close_connection(mysql_conn_t **mysql_conn)
 		return SLURM_SUCCESS;
 
 	acct_storage_p_commit((*mysql_conn), 0);
-	rc = destroy_mysql_conn(*mysql_conn);
+	if (_put_idle_conn(*mysql_conn))
+		rc = SLURM_SUCCESS;
+	else
+		rc = destroy_mysql_conn(*mysql_conn);
 	*mysql_conn = NULL;
 
 	return rc;
@@ -2198,6 +2300,13 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	if ((rc != SLURM_SUCCESS) && (rc != ESLURM_CLUSTER_DELETED))
 		return rc;
 
+	/* Inside a batch nothing is stored until the batch commits, so
+	 * hold the updates until then instead of telling the assoc_mgr
+	 * and the clusters about records that may still be rolled
+	 * back.  acct_storage_p_batch() sends or drops them. */
+	if (mysql_conn->batch_thread_id)
+		return SLURM_SUCCESS;
+
 	debug4("got %d commits", list_count(mysql_conn->update_list));
 
 	if (mysql_conn->rollback) {
@@ -2240,6 +2349,9 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 		char *rem_cluster = NULL, *cluster_name = NULL;
 		slurmdb_update_object_t *object = NULL;
 
+		/* usage is summed over the association tree */
+		as_mysql_usage_cache_clear();
+
 		xstrfmtcat(query, "select control_host, control_port, "
 			   "name, rpc_version "
 			   "from %s where deleted=0 && control_port != 0",
@@ -2301,6 +2413,61 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	return SLURM_SUCCESS;
 }
 
+extern int acct_storage_p_batch(mysql_conn_t *mysql_conn, bool start)
+{
+	int rc = SLURM_SUCCESS;
+
+	/* A connection with rollback is always inside a transaction
+	 * that its owner commits. */
+	if (mysql_conn->rollback)
+		return SLURM_SUCCESS;
+
+	if (start) {
+		if ((rc = check_connection(mysql_conn)) != SLURM_SUCCESS)
+			return rc;
+		mysql_autocommit(mysql_conn->db_conn, 0);
+		mysql_conn->batch_thread_id =
+			mysql_thread_id(mysql_conn->db_conn);
+		mysql_conn->trans_lost = false;
+		return SLURM_SUCCESS;
+	}
+
+	if (!mysql_conn->batch_thread_id)
+		return SLURM_SUCCESS;
+
+	/* If the connection was re-established during the batch, or the
+	 * server threw the transaction away on a deadlock, what was
+	 * written before that is gone while later statements may have
+	 * started a new transaction.  Fail the whole batch so it gets
+	 * sent again. */
+	if (!mysql_conn->db_conn
+	    || (mysql_thread_id(mysql_conn->db_conn)
+		!= mysql_conn->batch_thread_id)) {
+		error("lost the database connection during a batch");
+		rc = SLURM_ERROR;
+	} else if (mysql_conn->trans_lost) {
+		error("lost the transaction of a batch to a deadlock");
+		rc = SLURM_ERROR;
+	} else if (mysql_db_commit(mysql_conn) != SLURM_SUCCESS)
+		rc = SLURM_ERROR;
+
+	if (mysql_conn->db_conn) {
+		if (rc != SLURM_SUCCESS)
+			mysql_db_rollback(mysql_conn);
+		mysql_autocommit(mysql_conn->db_conn, 1);
+	}
+	mysql_conn->batch_thread_id = 0;
+
+	/* Send out the updates held back during the batch now that
+	 * they are stored, or throw them away with the batch. */
+	if (rc == SLURM_SUCCESS)
+		acct_storage_p_commit(mysql_conn, 1);
+	else
+		list_flush(mysql_conn->update_list);
+
+	return rc;
+}
+
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
 				    List user_list)
 {
@@ -43,6 +43,7 @@
 #include <unistd.h>
 
 #include "as_mysql_archive.h"
+#include "as_mysql_usage.h"
 #include "src/common/slurmdbd_defs.h"
 #include "src/common/env.h"
 
@@ -335,6 +336,15 @@ enum {
 	SUSPEND_REQ_COUNT
 };
 
+/* rows removed by one delete statement while purging */
+#define MAX_PURGE_LIMIT 50000
+/* archived records put in one insert statement while loading */
+#define MAX_ARCHIVE_LOAD 1000
+
+typedef uint32_t (*archive_func_t)(mysql_conn_t *mysql_conn,
+				   char *cluster_name, time_t period_end,
+				   char *arch_dir, uint32_t archive_period);
+
 static int high_buffer_size = (1024 * 1024);
 
 static void _pack_local_event(local_event_t *object,
@@ -1299,7 +1309,7 @@ static uint32_t _archive_jobs(mysql_conn_t *mysql_conn, char *cluster_name,
 
 	/* get all the events started before this time listed */
 	query = xstrdup_printf("select %s from \"%s_%s\" where "
-			       "time_submit < %ld && time_end != 0 && !deleted "
+			       "time_submit <= %ld && time_end != 0 && !deleted "
 			       "order by time_submit asc",
 			       tmp, cluster_name, job_table, period_end);
 	xfree(tmp);
@@ -1757,6 +1767,120 @@ static char *_load_suspend(uint16_t rpc_version, Buf buffer,
 	return insert;
 }
 
+/* Return the last second of the archive period (hour, day or month,
+ * depending on the purge units) that start falls in, or 0 on error.
+ */
+static time_t _get_period_end(time_t start, uint32_t archive_period)
+{
+	struct tm time_tm;
+	time_t period_end;
+
+	/* use localtime to avoid any daylight savings issues */
+	if (!localtime_r(&start, &time_tm)) {
+		error("Couldn't get localtime from %ld", (long)start);
+		return 0;
+	}
+
+	time_tm.tm_sec = 0;
+	time_tm.tm_min = 0;
+
+	if (SLURMDB_PURGE_IN_HOURS(archive_period))
+		time_tm.tm_hour++;
+	else if (SLURMDB_PURGE_IN_DAYS(archive_period)) {
+		time_tm.tm_hour = 0;
+		time_tm.tm_mday++;
+	} else {
+		time_tm.tm_hour = 0;
+		time_tm.tm_mday = 1;
+		time_tm.tm_mon++;
+	}
+
+	time_tm.tm_isdst = -1;
+	period_end = mktime(&time_tm) - 1;
+
+	/* always make progress, even across a daylight savings change */
+	return MAX(period_end, start);
+}
+
+/* Delete the rows of a table matching cond MAX_PURGE_LIMIT at a time so no
+ * single statement holds its locks for long.
+ */
+static int _purge_table(mysql_conn_t *mysql_conn, char *cluster_name,
+			char *table, char *cond)
+{
+	char *query = NULL;
+	int rc;
+
+	query = xstrdup_printf("delete from \"%s_%s\" where %s limit %d",
+			       cluster_name, table, cond, MAX_PURGE_LIMIT);
+	do {
+		debug3("%d(%s:%d) query\n%s",
+		       mysql_conn->conn, THIS_FILE, __LINE__, query);
+		if ((rc = mysql_db_query(mysql_conn, query)) != SLURM_SUCCESS)
+			break;
+	} while (mysql_affected_rows(mysql_conn->db_conn) >= MAX_PURGE_LIMIT);
+	xfree(query);
+
+	return rc;
+}
+
+/* Archive the rows of a table with col_time <= period_end matching cond one
+ * archive period at a time, purging each period's rows once its file is
+ * written.  This keeps both the result set being packed and the rows being
+ * deleted bounded by a single period instead of the whole history.  cond
+ * must select the same rows archive_func does.
+ */
+static int _archive_periods(mysql_conn_t *mysql_conn, char *cluster_name,
+			    char *table, char *col_time, char *cond,
+			    time_t period_end, char *arch_dir,
+			    uint32_t archive_period, archive_func_t archive_func)
+{
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	char *query = NULL;
+	time_t curr_end;
+	int rc = SLURM_SUCCESS;
+
+	while (1) {
+		query = xstrdup_printf("select min(%s) from \"%s_%s\" "
+				       "where %s <= %ld && %s",
+				       col_time, cluster_name, table,
+				       col_time, period_end, cond);
+		debug3("%d(%s:%d) query\n%s",
+		       mysql_conn->conn, THIS_FILE, __LINE__, query);
+		if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+			xfree(query);
+			return SLURM_ERROR;
+		}
+		xfree(query);
+
+		if (!(row = mysql_fetch_row(result)) || !row[0]) {
+			mysql_free_result(result);
+			break;
+		}
+		curr_end = _get_period_end(slurm_atoul(row[0]),
+					   archive_period);
+		mysql_free_result(result);
+		if (!curr_end)
+			return SLURM_ERROR;
+		if (curr_end > period_end)
+			curr_end = period_end;
+
+		if ((*archive_func)(mysql_conn, cluster_name, curr_end,
+				    arch_dir, archive_period) == SLURM_ERROR)
+			return SLURM_ERROR;
+
+		query = xstrdup_printf("%s <= %ld && %s",
+				       col_time, curr_end, cond);
+		rc = _purge_table(mysql_conn, cluster_name, table, query);
+		xfree(query);
+		if (rc != SLURM_SUCCESS)
+			break;
+	}
+
+	return rc;
+}
+
 static int _execute_archive(mysql_conn_t *mysql_conn,
 			    char *cluster_name,
 			    slurmdb_archive_cond_t *arch_cond)
@@ -1787,20 +1911,18 @@ static int _execute_archive(mysql_conn_t *mysql_conn,
 		       curr_end, cluster_name);
 
 		if (SLURMDB_PURGE_ARCHIVE_SET(arch_cond->purge_event)) {
-			rc = _archive_events(mysql_conn, cluster_name,
-					     curr_end, arch_cond->archive_dir,
-					     arch_cond->purge_event);
-			if (!rc)
-				goto exit_events;
-			else if (rc == SLURM_ERROR)
+			rc = _archive_periods(mysql_conn, cluster_name,
+					      event_table, "time_start",
+					      "time_end != 0", curr_end,
+					      arch_cond->archive_dir,
+					      arch_cond->purge_event,
+					      _archive_events);
+			if (rc != SLURM_SUCCESS)
 				return rc;
 		}
-		query = xstrdup_printf("delete from \"%s_%s\" where "
-				       "time_start <= %ld && time_end != 0",
-				       cluster_name, event_table, curr_end);
-		debug3("%d(%s:%d) query\n%s",
-		       mysql_conn->conn, THIS_FILE, __LINE__, query);
-		rc = mysql_db_query(mysql_conn, query);
+		query = xstrdup_printf("time_start <= %ld && time_end != 0",
+				       curr_end);
+		rc = _purge_table(mysql_conn, cluster_name, event_table, query);
 		xfree(query);
 		if (rc != SLURM_SUCCESS) {
 			error("Couldn't remove old event data");
@@ -1808,8 +1930,6 @@ static int _execute_archive(mysql_conn_t *mysql_conn,
 		}
 	}
 
-exit_events:
-
 	if (arch_cond->purge_suspend != NO_VAL) {
 		/* remove all data from suspend table that was older than
 		 * period_start * arch_cond->purge_suspend.
@@ -1824,20 +1944,19 @@ exit_events:
 		       curr_end, cluster_name);
 
 		if (SLURMDB_PURGE_ARCHIVE_SET(arch_cond->purge_suspend)) {
-			rc = _archive_suspend(mysql_conn, cluster_name,
-					      curr_end, arch_cond->archive_dir,
-					      arch_cond->purge_suspend);
-			if (!rc)
-				goto exit_suspend;
-			else if (rc == SLURM_ERROR)
+			rc = _archive_periods(mysql_conn, cluster_name,
+					      suspend_table, "time_start",
+					      "time_end != 0", curr_end,
+					      arch_cond->archive_dir,
+					      arch_cond->purge_suspend,
+					      _archive_suspend);
+			if (rc != SLURM_SUCCESS)
 				return rc;
 		}
-		query = xstrdup_printf("delete from \"%s_%s\" where "
-				       "time_start <= %ld && time_end != 0",
-				       cluster_name, suspend_table, curr_end);
-		debug3("%d(%s:%d) query\n%s",
-		       mysql_conn->conn, THIS_FILE, __LINE__, query);
-		rc = mysql_db_query(mysql_conn, query);
+		query = xstrdup_printf("time_start <= %ld && time_end != 0",
+				       curr_end);
+		rc = _purge_table(mysql_conn, cluster_name,
+				  suspend_table, query);
 		xfree(query);
 		if (rc != SLURM_SUCCESS) {
 			error("Couldn't remove old suspend data");
@@ -1845,8 +1964,6 @@ exit_events:
 		}
 	}
 
-exit_suspend:
-
 	if (arch_cond->purge_step != NO_VAL) {
 		/* remove all data from step table that was older than
 		 * start * arch_cond->purge_step.
@@ -1861,28 +1978,26 @@ exit_suspend:
 		       curr_end, cluster_name);
 
 		if (SLURMDB_PURGE_ARCHIVE_SET(arch_cond->purge_step)) {
-			rc = _archive_steps(mysql_conn, cluster_name,
-					    curr_end, arch_cond->archive_dir,
-					    arch_cond->purge_step);
-			if (!rc)
-				goto exit_steps;
-			else if (rc == SLURM_ERROR)
+			rc = _archive_periods(mysql_conn, cluster_name,
+					      step_table, "time_start",
+					      "time_end != 0 && !deleted",
+					      curr_end,
+					      arch_cond->archive_dir,
+					      arch_cond->purge_step,
+					      _archive_steps);
+			if (rc != SLURM_SUCCESS)
 				return rc;
 		}
 
-		query = xstrdup_printf("delete from \"%s_%s\" where "
-				       "time_start <= %ld && time_end != 0",
-				       cluster_name, step_table, curr_end);
-		debug3("%d(%s:%d) query\n%s",
-		       mysql_conn->conn, THIS_FILE, __LINE__, query);
-		rc = mysql_db_query(mysql_conn, query);
+		query = xstrdup_printf("time_start <= %ld && time_end != 0",
+				       curr_end);
+		rc = _purge_table(mysql_conn, cluster_name, step_table, query);
 		xfree(query);
 		if (rc != SLURM_SUCCESS) {
 			error("Couldn't remove old step data");
 			return SLURM_ERROR;
 		}
 	}
-exit_steps:
 
 	if (arch_cond->purge_job != NO_VAL) {
 		/* remove all data from job table that was older than
@@ -1898,29 +2013,27 @@ exit_steps:
 		       curr_end, cluster_name);
 
 		if (SLURMDB_PURGE_ARCHIVE_SET(arch_cond->purge_job)) {
-			rc = _archive_jobs(mysql_conn, cluster_name,
-					   curr_end, arch_cond->archive_dir,
-					   arch_cond->purge_job);
-			if (!rc)
-				goto exit_jobs;
-			else if (rc == SLURM_ERROR)
+			rc = _archive_periods(mysql_conn, cluster_name,
+					      job_table, "time_submit",
+					      "time_end != 0 && !deleted",
+					      curr_end,
+					      arch_cond->archive_dir,
+					      arch_cond->purge_job,
+					      _archive_jobs);
+			if (rc != SLURM_SUCCESS)
 				return rc;
 		}
 
-		query = xstrdup_printf("delete from \"%s_%s\" "
-				       "where time_submit <= %ld "
-				       "&& time_end != 0",
-				       cluster_name, job_table, curr_end);
-		debug3("%d(%s:%d) query\n%s",
-		       mysql_conn->conn, THIS_FILE, __LINE__, query);
-		rc = mysql_db_query(mysql_conn, query);
+		query = xstrdup_printf("time_submit <= %ld && time_end != 0",
+				       curr_end);
+		rc = _purge_table(mysql_conn, cluster_name, job_table, query);
 		xfree(query);
 		if (rc != SLURM_SUCCESS) {
 			error("Couldn't remove old job data");
 			return SLURM_ERROR;
 		}
 	}
-exit_jobs:
+
 	return SLURM_SUCCESS;
 }
 
@@ -2031,10 +2144,12 @@ extern int as_mysql_jobacct_process_archive_load(
 	}
 
 	buffer = create_buf(data, data_size);
+	/* the buffer owns the file data now */
+	data = NULL;
 
 	safe_unpack16(&ver, buffer);
 	debug3("Version in assoc_mgr_state header is %u", ver);
-	if (ver <= SLURMDBD_VERSION || ver < SLURMDBD_VERSION_MIN) {
+	if (ver > SLURMDBD_VERSION || ver < SLURMDBD_VERSION_MIN) {
 		error("***********************************************");
 		error("Can not recover archive file, incompatible version, "
 		      "got %u need > %u <= %u", ver,
@@ -2055,25 +2170,53 @@ extern int as_mysql_jobacct_process_archive_load(
 		goto got_sql;
 	}
 
-	switch(type) {
-	case DBD_GOT_EVENTS:
-		data = _load_events(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_GOT_JOBS:
-		data = _load_jobs(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_STEP_START:
-		data = _load_steps(ver, buffer, cluster_name, rec_cnt);
-		break;
-	case DBD_JOB_SUSPEND:
-		data = _load_suspend(ver, buffer, cluster_name, rec_cnt);
-		break;
-	default:
-		error("Unknown type '%u' to load from archive", type);
-		break;
+	/* Insert the records MAX_ARCHIVE_LOAD at a time so the statement
+	 * stays bounded no matter how large the archive is.
+	 */
+	while (rec_cnt) {
+		uint32_t cnt = MIN(rec_cnt, MAX_ARCHIVE_LOAD);
+
+		switch(type) {
+		case DBD_GOT_EVENTS:
+			data = _load_events(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_GOT_JOBS:
+			data = _load_jobs(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_STEP_START:
+			data = _load_steps(ver, buffer, cluster_name, cnt);
+			break;
+		case DBD_JOB_SUSPEND:
+			data = _load_suspend(ver, buffer, cluster_name, cnt);
+			break;
+		default:
+			error("Unknown type '%u' to load from archive", type);
+			break;
+		}
+		rec_cnt -= cnt;
+
+		if (!data) {
+			error("No data to load");
+			error_code = SLURM_ERROR;
+			break;
+		}
+		debug3("%d(%s:%d) query\n%s",
+		       mysql_conn->conn, THIS_FILE, __LINE__, data);
+		error_code = mysql_db_query_check_after(mysql_conn, data);
+		xfree(data);
+		if (error_code != SLURM_SUCCESS)
+			break;
 	}
 	free_buf(buffer);
 
+	if (error_code != SLURM_SUCCESS) {
+		error("Couldn't load old data");
+		return SLURM_ERROR;
+	}
+
+	as_mysql_usage_cache_clear();
+	return SLURM_SUCCESS;
+
 got_sql:
 	if (!data) {
 		error("No data to load");
@@ -2089,5 +2232,6 @@ got_sql:
 		return SLURM_ERROR;
 	}
 
+	as_mysql_usage_cache_clear();
 	return SLURM_SUCCESS;
 }
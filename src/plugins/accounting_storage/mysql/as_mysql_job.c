@@ -176,6 +176,7 @@ static uint32_t _get_wckeyid(mysql_conn_t *mysql_conn, char **name,
 					    NULL) != SLURM_SUCCESS) {
 			List wckey_list = NULL;
 			slurmdb_wckey_rec_t *wckey_ptr = NULL;
+			uint32_t added_id = 0;
 
 			wckey_list = list_create(slurmdb_destroy_wckey_rec);
 
@@ -193,12 +194,21 @@ static uint32_t _get_wckeyid(mysql_conn_t *mysql_conn, char **name,
 			if (as_mysql_add_wckeys(mysql_conn,
 						slurm_get_slurm_user_id(),
 						wckey_list)
-			    == SLURM_SUCCESS)
+			    == SLURM_SUCCESS) {
+				/* Inside a batch the commit holds the
+				   new wckey back from the assoc_mgr
+				   until the batch is stored, so
+				   remember its id here. */
+				added_id = wckey_ptr->id;
 				acct_storage_p_commit(mysql_conn, 1);
+			}
 			/* If that worked lets get it */
-			assoc_mgr_fill_in_wckey(mysql_conn, &wckey_rec,
-						ACCOUNTING_ENFORCE_WCKEYS,
-						NULL);
+			if ((assoc_mgr_fill_in_wckey(
+				     mysql_conn, &wckey_rec,
+				     ACCOUNTING_ENFORCE_WCKEYS,
+				     NULL) != SLURM_SUCCESS)
+			    && added_id)
+				wckey_rec.id = added_id;
 
 			list_destroy(wckey_list);
 		}
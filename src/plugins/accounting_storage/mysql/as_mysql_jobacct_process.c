@@ -308,6 +308,228 @@ static void _destroy_local_cluster(void *object)
 	}
 }
 
+/* Steps are read for this many jobs in one query instead of a query
+ * for every job. */
+#define STEP_QUERY_JOBS 1000
+
+typedef struct {
+	uint32_t db_inx;
+	bool ended;
+	slurmdb_job_rec_t *job;
+	int submit;
+} local_step_job_t;
+
+/* Add a step to job filled in from a row of step_req_inx fields */
+static void _set_step_rec(slurmdb_job_rec_t *job, MYSQL_ROW step_row,
+			  bool job_ended, slurmdb_job_cond_t *job_cond,
+			  time_t now)
+{
+	slurmdb_step_rec_t *step = slurmdb_create_step_rec();
+
+	step->tot_cpu_sec = 0;
+	step->tot_cpu_usec = 0;
+	step->job_ptr = job;
+	if (!job->first_step_ptr)
+		job->first_step_ptr = step;
+	list_append(job->steps, step);
+	step->stepid = slurm_atoul(step_row[STEP_REQ_STEPID]);
+	/* info("got step %u.%u", */
+	/*      job->header.jobnum, step->stepnum); */
+	step->state = slurm_atoul(step_row[STEP_REQ_STATE]);
+	step->exitcode =
+		slurm_atoul(step_row[STEP_REQ_EXIT_CODE]);
+	step->ncpus = slurm_atoul(step_row[STEP_REQ_CPUS]);
+	step->nnodes = slurm_atoul(step_row[STEP_REQ_NODES]);
+
+	step->ntasks = slurm_atoul(step_row[STEP_REQ_TASKS]);
+	step->task_dist =
+		slurm_atoul(step_row[STEP_REQ_TASKDIST]);
+	if (!step->ntasks)
+		step->ntasks = step->ncpus;
+
+	step->start = slurm_atoul(step_row[STEP_REQ_START]);
+
+	step->end = slurm_atoul(step_row[STEP_REQ_END]);
+	/* if the job has ended end the step also */
+	if (!step->end && job_ended) {
+		step->end = job->end;
+		step->state = job->state;
+	}
+
+	if (job_cond && !job_cond->without_usage_truncation
+	    && job_cond->usage_start) {
+		if (step->start
+		    && (step->start < job_cond->usage_start))
+			step->start = job_cond->usage_start;
+
+		if (!step->start && step->end)
+			step->start = step->end;
+
+		if (!step->end
+		    || (step->end > job_cond->usage_end))
+			step->end = job_cond->usage_end;
+	}
+
+	/* figure this out by start stop */
+	step->suspended =
+		slurm_atoul(step_row[STEP_REQ_SUSPENDED]);
+	if (!step->start) {
+		step->elapsed = 0;
+	} else if (!step->end) {
+		step->elapsed = now - step->start;
+	} else {
+		step->elapsed = step->end - step->start;
+	}
+	step->elapsed -= step->suspended;
+
+	if ((int)step->elapsed < 0)
+		step->elapsed = 0;
+
+	step->user_cpu_sec =
+		slurm_atoul(step_row[STEP_REQ_USER_SEC]);
+	step->user_cpu_usec =
+		slurm_atoul(step_row[STEP_REQ_USER_USEC]);
+	step->sys_cpu_sec =
+		slurm_atoul(step_row[STEP_REQ_SYS_SEC]);
+	step->sys_cpu_usec =
+		slurm_atoul(step_row[STEP_REQ_SYS_USEC]);
+	step->tot_cpu_sec +=
+		step->user_cpu_sec + step->sys_cpu_sec;
+	step->tot_cpu_usec +=
+		step->user_cpu_usec + step->sys_cpu_usec;
+	step->stats.vsize_max =
+		slurm_atoul(step_row[STEP_REQ_MAX_VSIZE]);
+	step->stats.vsize_max_taskid =
+		slurm_atoul(step_row[STEP_REQ_MAX_VSIZE_TASK]);
+	step->stats.vsize_ave =
+		atof(step_row[STEP_REQ_AVE_VSIZE]);
+	step->stats.rss_max =
+		slurm_atoul(step_row[STEP_REQ_MAX_RSS]);
+	step->stats.rss_max_taskid =
+		slurm_atoul(step_row[STEP_REQ_MAX_RSS_TASK]);
+	step->stats.rss_ave =
+		atof(step_row[STEP_REQ_AVE_RSS]);
+	step->stats.pages_max =
+		slurm_atoul(step_row[STEP_REQ_MAX_PAGES]);
+	step->stats.pages_max_taskid =
+		slurm_atoul(step_row[STEP_REQ_MAX_PAGES_TASK]);
+	step->stats.pages_ave =
+		atof(step_row[STEP_REQ_AVE_PAGES]);
+	step->stats.cpu_min =
+		slurm_atoul(step_row[STEP_REQ_MIN_CPU]);
+	step->stats.cpu_min_taskid =
+		slurm_atoul(step_row[STEP_REQ_MIN_CPU_TASK]);
+	step->stats.cpu_ave = atof(step_row[STEP_REQ_AVE_CPU]);
+	step->stats.act_cpufreq =
+			atof(step_row[STEP_REQ_ACT_CPUFREQ]);
+	step->stats.consumed_energy =
+			atof(step_row[STEP_REQ_CONSUMED_ENERGY]);
+	step->stepname = xstrdup(step_row[STEP_REQ_NAME]);
+	step->nodes = xstrdup(step_row[STEP_REQ_NODELIST]);
+	step->stats.vsize_max_nodeid =
+		slurm_atoul(step_row[STEP_REQ_MAX_VSIZE_NODE]);
+	step->stats.rss_max_nodeid =
+		slurm_atoul(step_row[STEP_REQ_MAX_RSS_NODE]);
+	step->stats.pages_max_nodeid =
+		slurm_atoul(step_row[STEP_REQ_MAX_PAGES_NODE]);
+	step->stats.cpu_min_nodeid =
+		slurm_atoul(step_row[STEP_REQ_MIN_CPU_NODE]);
+
+	step->requid =
+		slurm_atoul(step_row[STEP_REQ_KILL_REQUID]);
+}
+
+static void _set_track_steps(slurmdb_job_rec_t *job)
+{
+	slurmdb_step_rec_t *step = job->first_step_ptr;
+
+	if (!job->track_steps) {
+		/* If we don't have track_steps we want to see
+		   if we have multiple steps.  If we only have
+		   1 step check the job name against the step
+		   name in most all cases it will be
+		   different.  If it is different print out
+		   the step separate.
+		*/
+		if (list_count(job->steps) > 1)
+			job->track_steps = 1;
+		else if (step && step->stepname && job->jobname) {
+			if (strcmp(step->stepname, job->jobname))
+				job->track_steps = 1;
+		}
+	}
+}
+
+static int _sort_step_job_inx(const void *a, const void *b)
+{
+	const local_step_job_t *job_a = a, *job_b = b;
+
+	if (job_a->db_inx < job_b->db_inx)
+		return -1;
+	else if (job_a->db_inx > job_b->db_inx)
+		return 1;
+	return 0;
+}
+
+/* Get the steps of step_jobs with one query, the rows come back in
+ * job_db_inx order and are matched up against step_jobs sorted the same
+ * way. */
+static int _get_job_steps(mysql_conn_t *mysql_conn, char *cluster_name,
+			  char *step_fields, slurmdb_job_cond_t *job_cond,
+			  local_step_job_t *step_jobs, int job_cnt,
+			  List local_cluster_list,
+			  local_cluster_t **curr_cluster, time_t now)
+{
+	char *query = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	uint32_t db_inx;
+	int i;
+
+	qsort(step_jobs, job_cnt, sizeof(local_step_job_t),
+	      _sort_step_job_inx);
+
+	query = xstrdup_printf("select t1.job_db_inx, %s from \"%s_%s\" "
+			       "as t1 where t1.job_db_inx in (",
+			       step_fields, cluster_name, step_table);
+	for (i = 0; i < job_cnt; i++)
+		xstrfmtcat(query, i ? ", %u" : "%u", step_jobs[i].db_inx);
+	xstrcat(query, ") order by t1.job_db_inx, t1.id_step");
+
+	debug4("%d(%s:%d) query\n%s",
+	       mysql_conn->conn, THIS_FILE, __LINE__, query);
+	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+		xfree(query);
+		return SLURM_ERROR;
+	}
+	xfree(query);
+
+	i = 0;
+	while ((row = mysql_fetch_row(result))) {
+		db_inx = slurm_atoul(row[0]);
+		while ((i < job_cnt) && (step_jobs[i].db_inx < db_inx))
+			i++;
+		if (i >= job_cnt)
+			break;
+		if (step_jobs[i].db_inx != db_inx)
+			continue;
+		/* the step fields start after job_db_inx */
+		if (!good_nodes_from_inx(local_cluster_list,
+					 (void **)curr_cluster,
+					 row[1 + STEP_REQ_NODE_INX],
+					 step_jobs[i].submit))
+			continue;
+		_set_step_rec(step_jobs[i].job, row + 1, step_jobs[i].ended,
+			      job_cond, now);
+	}
+	mysql_free_result(result);
+
+	for (i = 0; i < job_cnt; i++)
+		_set_track_steps(step_jobs[i].job);
+
+	return SLURM_SUCCESS;
+}
+
 static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     slurmdb_user_rec_t *user,
 			     slurmdb_job_cond_t *job_cond,
@@ -323,9 +545,12 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL, *step_result = NULL;
 	MYSQL_ROW row, step_row;
 	slurmdb_job_rec_t *job = NULL;
-	slurmdb_step_rec_t *step = NULL;
 	time_t now = time(NULL);
 	List job_list = list_create(slurmdb_destroy_job_rec);
+	bool step_list = (job_cond && job_cond->step_list
+			  && list_count(job_cond->step_list));
+	local_step_job_t *step_jobs = NULL;
+	int step_job_cnt = 0;
 	ListIterator itr = NULL;
 	List local_cluster_list = NULL;
 	int set = 0;
@@ -540,8 +765,8 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 				if (!(result2 = mysql_db_query_ret(
 					      mysql_conn,
 					      query, 0))) {
-					list_destroy(job_list);
-					job_list = NULL;
+					xfree(query);
+					rc = SLURM_ERROR;
 					break;
 				}
 				xfree(query);
@@ -618,35 +843,56 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 		if (only_pending || (job_cond && job_cond->without_steps))
 			goto skip_steps;
 
-		if (job_cond && job_cond->step_list
-		    && list_count(job_cond->step_list)) {
-			set = 0;
-			itr = list_iterator_create(job_cond->step_list);
-			while ((selected_step = list_next(itr))) {
-				if (selected_step->jobid != job->jobid) {
-					continue;
-				} else if (selected_step->stepid == NO_VAL) {
-					job->show_full = 1;
+		/* Unless only some steps were asked for the steps are
+		   read for a batch of jobs at a time. */
+		if (!step_list) {
+			if (!step_jobs)
+				step_jobs = xmalloc(sizeof(local_step_job_t)
+						    * STEP_QUERY_JOBS);
+			else if (step_job_cnt == STEP_QUERY_JOBS) {
+				if ((rc = _get_job_steps(
+					     mysql_conn, cluster_name,
+					     step_fields, job_cond, step_jobs,
+					     step_job_cnt, local_cluster_list,
+					     &curr_cluster, now))
+				    != SLURM_SUCCESS)
 					break;
-				} else if (selected_step->stepid == INFINITE)
-					selected_step->stepid =
-						SLURM_BATCH_SCRIPT;
+				step_job_cnt = 0;
+			}
+			step_jobs[step_job_cnt].db_inx = slurm_atoul(id);
+			step_jobs[step_job_cnt].ended = job_ended;
+			step_jobs[step_job_cnt].job = job;
+			step_jobs[step_job_cnt].submit = submit;
+			step_job_cnt++;
+			goto skip_steps;
+		}
 
-				if (set)
-					xstrcat(extra, " || ");
-				else
-					xstrcat(extra, " && (");
+		set = 0;
+		itr = list_iterator_create(job_cond->step_list);
+		while ((selected_step = list_next(itr))) {
+			if (selected_step->jobid != job->jobid) {
+				continue;
+			} else if (selected_step->stepid == NO_VAL) {
+				job->show_full = 1;
+				break;
+			} else if (selected_step->stepid == INFINITE)
+				selected_step->stepid =
+					SLURM_BATCH_SCRIPT;
 
-				/* The stepid could be -2 so use %d not %u */
-				xstrfmtcat(extra, "t1.id_step=%d",
-					   selected_step->stepid);
-				set = 1;
-				job->show_full = 0;
-			}
-			list_iterator_destroy(itr);
 			if (set)
-				xstrcat(extra, ")");
+				xstrcat(extra, " || ");
+			else
+				xstrcat(extra, " && (");
+
+			/* The stepid could be -2 so use %d not %u */
+			xstrfmtcat(extra, "t1.id_step=%d",
+				   selected_step->stepid);
+			set = 1;
+			job->show_full = 0;
 		}
+		list_iterator_destroy(itr);
+		if (set)
+			xstrcat(extra, ")");
 		query =	xstrdup_printf("select %s from \"%s_%s\" as t1 "
 				       "where t1.job_db_inx=%s",
 				       step_fields, cluster_name,
@@ -667,10 +913,6 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 		}
 		xfree(query);
 
-		/* Querying the steps in the fashion was faster than
-		   doing only 1 query and then matching the steps up
-		   later with the job.
-		*/
 		while ((step_row = mysql_fetch_row(step_result))) {
 			/* check the bitmap to see if this is one of the steps
 			   we are looking for */
@@ -680,143 +922,23 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 						 submit))
 				continue;
 
-			step = slurmdb_create_step_rec();
-			step->tot_cpu_sec = 0;
-			step->tot_cpu_usec = 0;
-			step->job_ptr = job;
-			if (!job->first_step_ptr)
-				job->first_step_ptr = step;
-			list_append(job->steps, step);
-			step->stepid = slurm_atoul(step_row[STEP_REQ_STEPID]);
-			/* info("got step %u.%u", */
-/* 			     job->header.jobnum, step->stepnum); */
-			step->state = slurm_atoul(step_row[STEP_REQ_STATE]);
-			step->exitcode =
-				slurm_atoul(step_row[STEP_REQ_EXIT_CODE]);
-			step->ncpus = slurm_atoul(step_row[STEP_REQ_CPUS]);
-			step->nnodes = slurm_atoul(step_row[STEP_REQ_NODES]);
-
-			step->ntasks = slurm_atoul(step_row[STEP_REQ_TASKS]);
-			step->task_dist =
-				slurm_atoul(step_row[STEP_REQ_TASKDIST]);
-			if (!step->ntasks)
-				step->ntasks = step->ncpus;
-
-			step->start = slurm_atoul(step_row[STEP_REQ_START]);
-
-			step->end = slurm_atoul(step_row[STEP_REQ_END]);
-			/* if the job has ended end the step also */
-			if (!step->end && job_ended) {
-				step->end = job->end;
-				step->state = job->state;
-			}
-
-			if (job_cond && !job_cond->without_usage_truncation
-			    && job_cond->usage_start) {
-				if (step->start
-				    && (step->start < job_cond->usage_start))
-					step->start = job_cond->usage_start;
-
-				if (!step->start && step->end)
-					step->start = step->end;
-
-				if (!step->end
-				    || (step->end > job_cond->usage_end))
-					step->end = job_cond->usage_end;
-			}
-
-			/* figure this out by start stop */
-			step->suspended =
-				slurm_atoul(step_row[STEP_REQ_SUSPENDED]);
-			if (!step->start) {
-				step->elapsed = 0;
-			} else if (!step->end) {
-				step->elapsed = now - step->start;
-			} else {
-				step->elapsed = step->end - step->start;
-			}
-			step->elapsed -= step->suspended;
-
-			if ((int)step->elapsed < 0)
-				step->elapsed = 0;
-
-			step->user_cpu_sec =
-				slurm_atoul(step_row[STEP_REQ_USER_SEC]);
-			step->user_cpu_usec =
-				slurm_atoul(step_row[STEP_REQ_USER_USEC]);
-			step->sys_cpu_sec =
-				slurm_atoul(step_row[STEP_REQ_SYS_SEC]);
-			step->sys_cpu_usec =
-				slurm_atoul(step_row[STEP_REQ_SYS_USEC]);
-			step->tot_cpu_sec +=
-				step->user_cpu_sec + step->sys_cpu_sec;
-			step->tot_cpu_usec +=
-				step->user_cpu_usec + step->sys_cpu_usec;
-			step->stats.vsize_max =
-				slurm_atoul(step_row[STEP_REQ_MAX_VSIZE]);
-			step->stats.vsize_max_taskid =
-				slurm_atoul(step_row[STEP_REQ_MAX_VSIZE_TASK]);
-			step->stats.vsize_ave =
-				atof(step_row[STEP_REQ_AVE_VSIZE]);
-			step->stats.rss_max =
-				slurm_atoul(step_row[STEP_REQ_MAX_RSS]);
-			step->stats.rss_max_taskid =
-				slurm_atoul(step_row[STEP_REQ_MAX_RSS_TASK]);
-			step->stats.rss_ave =
-				atof(step_row[STEP_REQ_AVE_RSS]);
-			step->stats.pages_max =
-				slurm_atoul(step_row[STEP_REQ_MAX_PAGES]);
-			step->stats.pages_max_taskid =
-				slurm_atoul(step_row[STEP_REQ_MAX_PAGES_TASK]);
-			step->stats.pages_ave =
-				atof(step_row[STEP_REQ_AVE_PAGES]);
-			step->stats.cpu_min =
-				slurm_atoul(step_row[STEP_REQ_MIN_CPU]);
-			step->stats.cpu_min_taskid =
-				slurm_atoul(step_row[STEP_REQ_MIN_CPU_TASK]);
-			step->stats.cpu_ave = atof(step_row[STEP_REQ_AVE_CPU]);
-			step->stats.act_cpufreq =
-					atof(step_row[STEP_REQ_ACT_CPUFREQ]);
-			step->stats.consumed_energy =
-					atof(step_row[STEP_REQ_CONSUMED_ENERGY]);
-			step->stepname = xstrdup(step_row[STEP_REQ_NAME]);
-			step->nodes = xstrdup(step_row[STEP_REQ_NODELIST]);
-			step->stats.vsize_max_nodeid =
-				slurm_atoul(step_row[STEP_REQ_MAX_VSIZE_NODE]);
-			step->stats.rss_max_nodeid =
-				slurm_atoul(step_row[STEP_REQ_MAX_RSS_NODE]);
-			step->stats.pages_max_nodeid =
-				slurm_atoul(step_row[STEP_REQ_MAX_PAGES_NODE]);
-			step->stats.cpu_min_nodeid =
-				slurm_atoul(step_row[STEP_REQ_MIN_CPU_NODE]);
-
-			step->requid =
-				slurm_atoul(step_row[STEP_REQ_KILL_REQUID]);
+			_set_step_rec(job, step_row, job_ended, job_cond, now);
 		}
 		mysql_free_result(step_result);
 
-		if (!job->track_steps) {
-			/* If we don't have track_steps we want to see
-			   if we have multiple steps.  If we only have
-			   1 step check the job name against the step
-			   name in most all cases it will be
-			   different.  If it is different print out
-			   the step separate.
-			*/
-			if (list_count(job->steps) > 1)
-				job->track_steps = 1;
-			else if (step && step->stepname && job->jobname) {
-				if (strcmp(step->stepname, job->jobname))
-					job->track_steps = 1;
-			}
-		}
+		_set_track_steps(job);
 	skip_steps:
-		/* need to reset here to make the above test valid */
-		step = NULL;
+		;
 	}
 	mysql_free_result(result);
 
+	if ((rc == SLURM_SUCCESS) && step_job_cnt)
+		rc = _get_job_steps(mysql_conn, cluster_name, step_fields,
+				    job_cond, step_jobs, step_job_cnt,
+				    local_cluster_list, &curr_cluster, now);
+
 end_it:
+	xfree(step_jobs);
 	if (local_cluster_list)
 		list_destroy(local_cluster_list);
 
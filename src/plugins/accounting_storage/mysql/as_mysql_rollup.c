@@ -71,6 +71,33 @@ typedef struct {
 	time_t end;
 } local_resv_usage_t;
 
+/* The jobs and suspend records the hourly rollup works from are read
+ * once for this many hours instead of once an hour.  Neither table is
+ * indexed on time, so catching up on a long stretch of hours would
+ * otherwise scan them again for every hour.
+ */
+#define ROLLUP_CACHE_HOURS 24
+
+typedef struct {
+	uint32_t acpu;
+	uint32_t assoc_id;
+	uint32_t db_inx;
+	time_t eligible;
+	time_t end;
+	uint32_t id;
+	uint32_t rcpu;
+	uint32_t resv_id;
+	time_t start;
+	bool suspended;
+	uint32_t wckey_id;
+} local_job_t;
+
+typedef struct {
+	uint32_t db_inx;
+	time_t end;
+	time_t start;
+} local_suspend_t;
+
 static void _destroy_local_id_usage(void *object)
 {
 	local_id_usage_t *a_usage = (local_id_usage_t *)object;
@@ -97,6 +124,151 @@ static void _destroy_local_resv_usage(void *object)
 	}
 }
 
+/* Fill jobs with every job that could have used time between start and
+ * end, sorted the way the hourly rollup wants them. */
+static int _get_local_jobs(mysql_conn_t *mysql_conn, char *cluster_name,
+			   time_t start, time_t end,
+			   local_job_t **jobs, int *job_cnt)
+{
+	char *query = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	local_job_t *job;
+	int i = 0;
+
+	char *job_req_inx[] = {
+		"job_db_inx",
+		"id_job",
+		"id_assoc",
+		"id_wckey",
+		"time_eligible",
+		"time_start",
+		"time_end",
+		"time_suspended",
+		"cpus_alloc",
+		"cpus_req",
+		"id_resv"
+	};
+	char *job_str = NULL;
+	enum {
+		JOB_REQ_DB_INX,
+		JOB_REQ_JOBID,
+		JOB_REQ_ASSOCID,
+		JOB_REQ_WCKEYID,
+		JOB_REQ_ELG,
+		JOB_REQ_START,
+		JOB_REQ_END,
+		JOB_REQ_SUSPENDED,
+		JOB_REQ_ACPU,
+		JOB_REQ_RCPU,
+		JOB_REQ_RESVID,
+		JOB_REQ_COUNT
+	};
+
+	xfree(*jobs);
+	*job_cnt = 0;
+
+	xstrfmtcat(job_str, "%s", job_req_inx[i]);
+	for(i=1; i<JOB_REQ_COUNT; i++) {
+		xstrfmtcat(job_str, ", %s", job_req_inx[i]);
+	}
+
+	query = xstrdup_printf("select %s from \"%s_%s\" where "
+			       "(time_eligible < %ld && "
+			       "(time_end >= %ld || time_end = 0)) "
+			       "order by id_assoc, time_eligible",
+			       job_str, cluster_name, job_table,
+			       end, start);
+	xfree(job_str);
+
+	debug3("%d(%s:%d) query\n%s",
+	       mysql_conn->conn, THIS_FILE, __LINE__, query);
+	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+		xfree(query);
+		return SLURM_ERROR;
+	}
+	xfree(query);
+
+	*jobs = xmalloc(sizeof(local_job_t) * (mysql_num_rows(result) + 1));
+	while ((row = mysql_fetch_row(result))) {
+		job = &(*jobs)[(*job_cnt)++];
+		job->db_inx = slurm_atoul(row[JOB_REQ_DB_INX]);
+		job->id = slurm_atoul(row[JOB_REQ_JOBID]);
+		job->assoc_id = slurm_atoul(row[JOB_REQ_ASSOCID]);
+		job->wckey_id = slurm_atoul(row[JOB_REQ_WCKEYID]);
+		job->eligible = slurm_atoul(row[JOB_REQ_ELG]);
+		job->start = slurm_atoul(row[JOB_REQ_START]);
+		job->end = slurm_atoul(row[JOB_REQ_END]);
+		job->suspended = slurm_atoul(row[JOB_REQ_SUSPENDED]) ? 1 : 0;
+		job->acpu = slurm_atoul(row[JOB_REQ_ACPU]);
+		job->rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
+		job->resv_id = slurm_atoul(row[JOB_REQ_RESVID]);
+	}
+	mysql_free_result(result);
+
+	return SLURM_SUCCESS;
+}
+
+/* Fill suspends with the suspend records between start and end, sorted
+ * by job so _find_local_suspend can get to those of one job. */
+static int _get_local_suspends(mysql_conn_t *mysql_conn, char *cluster_name,
+			       time_t start, time_t end,
+			       local_suspend_t **suspends, int *suspend_cnt)
+{
+	char *query = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	local_suspend_t *suspend;
+
+	xfree(*suspends);
+	*suspend_cnt = 0;
+
+	query = xstrdup_printf("select job_db_inx, time_start, time_end "
+			       "from \"%s_%s\" where "
+			       "(time_start < %ld && (time_end >= %ld "
+			       "|| time_end = 0)) "
+			       "order by job_db_inx, time_start",
+			       cluster_name, suspend_table, end, start);
+
+	debug3("%d(%s:%d) query\n%s",
+	       mysql_conn->conn, THIS_FILE, __LINE__, query);
+	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+		xfree(query);
+		return SLURM_ERROR;
+	}
+	xfree(query);
+
+	*suspends = xmalloc(sizeof(local_suspend_t) *
+			    (mysql_num_rows(result) + 1));
+	while ((row = mysql_fetch_row(result))) {
+		suspend = &(*suspends)[(*suspend_cnt)++];
+		suspend->db_inx = slurm_atoul(row[0]);
+		suspend->start = slurm_atoul(row[1]);
+		suspend->end = slurm_atoul(row[2]);
+	}
+	mysql_free_result(result);
+
+	return SLURM_SUCCESS;
+}
+
+/* Return the index of the first suspend record of job db_inx, or -1 */
+static int _find_local_suspend(local_suspend_t *suspends, int suspend_cnt,
+			       uint32_t db_inx)
+{
+	int lo = 0, hi = suspend_cnt;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (suspends[mid].db_inx < db_inx)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if ((lo < suspend_cnt) && (suspends[lo].db_inx == db_inx))
+		return lo;
+	return -1;
+}
+
 static int _process_purge(mysql_conn_t *mysql_conn,
 			  char *cluster_name,
 			  uint16_t archive_data,
@@ -469,49 +641,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	List wckey_usage_list = list_create(_destroy_local_id_usage);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
 	uint16_t track_wckey = slurm_get_track_wckey();
+	local_job_t *jobs = NULL;
+	local_suspend_t *suspends = NULL;
+	int job_cnt = 0, suspend_cnt = 0;
+	time_t cache_end = 0;
 	/* char start_char[20], end_char[20]; */
 
-	char *job_req_inx[] = {
-		"job_db_inx",
-		"id_job",
-		"id_assoc",
-		"id_wckey",
-		"time_eligible",
-		"time_start",
-		"time_end",
-		"time_suspended",
-		"cpus_alloc",
-		"cpus_req",
-		"id_resv"
-
-	};
-	char *job_str = NULL;
-	enum {
-		JOB_REQ_DB_INX,
-		JOB_REQ_JOBID,
-		JOB_REQ_ASSOCID,
-		JOB_REQ_WCKEYID,
-		JOB_REQ_ELG,
-		JOB_REQ_START,
-		JOB_REQ_END,
-		JOB_REQ_SUSPENDED,
-		JOB_REQ_ACPU,
-		JOB_REQ_RCPU,
-		JOB_REQ_RESVID,
-		JOB_REQ_COUNT
-	};
-
-	char *suspend_req_inx[] = {
-		"time_start",
-		"time_end"
-	};
-	char *suspend_str = NULL;
-	enum {
-		SUSPEND_REQ_START,
-		SUSPEND_REQ_END,
-		SUSPEND_REQ_COUNT
-	};
-
 	char *resv_req_inx[] = {
 		"id_resv",
 		"assoclist",
@@ -531,18 +666,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		RESV_REQ_COUNT
 	};
 
-	i=0;
-	xstrfmtcat(job_str, "%s", job_req_inx[i]);
-	for(i=1; i<JOB_REQ_COUNT; i++) {
-		xstrfmtcat(job_str, ", %s", job_req_inx[i]);
-	}
-
-	i=0;
-	xstrfmtcat(suspend_str, "%s", suspend_req_inx[i]);
-	for(i=1; i<SUSPEND_REQ_COUNT; i++) {
-		xstrfmtcat(suspend_str, ", %s", suspend_req_inx[i]);
-	}
-
 	i=0;
 	xstrfmtcat(resv_str, "%s", resv_req_inx[i]);
 	for(i=1; i<RESV_REQ_COUNT; i++) {
@@ -560,6 +683,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		int last_wckeyid = -1;
 		int seconds = 0;
 		int tot_time = 0;
+		int j, s;
 		local_cluster_usage_t *loc_c_usage = NULL;
 		local_cluster_usage_t *c_usage = NULL;
 		local_resv_usage_t *r_usage = NULL;
@@ -588,7 +712,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			     mysql_conn, query, 0))) {
 			xfree(query);
 			_destroy_local_cluster_usage(c_usage);
-			return SLURM_ERROR;
+			rc = SLURM_ERROR;
+			goto end_it;
 		}
 		xfree(query);
 
@@ -673,35 +798,40 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		mysql_free_result(result);
 
 		/* now get the jobs during this time only  */
-		query = xstrdup_printf("select %s from \"%s_%s\" where "
-				       "(time_eligible < %ld && "
-				       "(time_end >= %ld || time_end = 0)) "
-				       "order by id_assoc, time_eligible",
-				       job_str, cluster_name, job_table,
-				       curr_end, curr_start);
-
-		debug3("%d(%s:%d) query\n%s",
-		       mysql_conn->conn, THIS_FILE, __LINE__, query);
-		if (!(result = mysql_db_query_ret(
-			     mysql_conn, query, 0))) {
-			xfree(query);
-			_destroy_local_cluster_usage(c_usage);
-			return SLURM_ERROR;
+		if (curr_end > cache_end) {
+			cache_end = curr_start
+				+ (ROLLUP_CACHE_HOURS * add_sec);
+			if ((_get_local_jobs(mysql_conn, cluster_name,
+					     curr_start, cache_end,
+					     &jobs, &job_cnt)
+			     != SLURM_SUCCESS)
+			    || (_get_local_suspends(mysql_conn, cluster_name,
+						    curr_start, cache_end,
+						    &suspends, &suspend_cnt)
+				!= SLURM_SUCCESS)) {
+				_destroy_local_cluster_usage(c_usage);
+				rc = SLURM_ERROR;
+				goto end_it;
+			}
 		}
-		xfree(query);
 
-		while ((row = mysql_fetch_row(result))) {
-			uint32_t job_id = slurm_atoul(row[JOB_REQ_JOBID]);
-			uint32_t assoc_id = slurm_atoul(row[JOB_REQ_ASSOCID]);
-			uint32_t wckey_id = slurm_atoul(row[JOB_REQ_WCKEYID]);
-			uint32_t resv_id = slurm_atoul(row[JOB_REQ_RESVID]);
-			time_t row_eligible = slurm_atoul(row[JOB_REQ_ELG]);
-			time_t row_start = slurm_atoul(row[JOB_REQ_START]);
-			time_t row_end = slurm_atoul(row[JOB_REQ_END]);
-			uint32_t row_acpu = slurm_atoul(row[JOB_REQ_ACPU]);
-			uint32_t row_rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
+		for (j = 0; j < job_cnt; j++) {
+			uint32_t job_id = jobs[j].id;
+			uint32_t assoc_id = jobs[j].assoc_id;
+			uint32_t wckey_id = jobs[j].wckey_id;
+			uint32_t resv_id = jobs[j].resv_id;
+			time_t row_eligible = jobs[j].eligible;
+			time_t row_start = jobs[j].start;
+			time_t row_end = jobs[j].end;
+			uint32_t row_acpu = jobs[j].acpu;
+			uint32_t row_rcpu = jobs[j].rcpu;
 			seconds = 0;
 
+			/* skip the jobs cached for other hours */
+			if ((row_eligible >= curr_end)
+			    || (row_end && (row_end < curr_start)))
+				continue;
+
 			if (row_start && (row_start < curr_start))
 				row_start = curr_start;
 
@@ -716,36 +846,20 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 			seconds = (row_end - row_start);
 
-			if (slurm_atoul(row[JOB_REQ_SUSPENDED])) {
-				MYSQL_RES *result2 = NULL;
-				MYSQL_ROW row2;
+			if (jobs[j].suspended) {
 				/* get the suspended time for this job */
-				query = xstrdup_printf(
-					"select %s from \"%s_%s\" where "
-					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
-					"order by time_start",
-					suspend_str, cluster_name,
-					suspend_table,
-					curr_end, curr_start,
-					row[JOB_REQ_DB_INX]);
-
-				debug4("%d(%s:%d) query\n%s",
-				       mysql_conn->conn, THIS_FILE,
-				       __LINE__, query);
-				if (!(result2 = mysql_db_query_ret(
-					     mysql_conn,
-					     query, 0))) {
-					xfree(query);
-					_destroy_local_cluster_usage(c_usage);
-					return SLURM_ERROR;
-				}
-				xfree(query);
-				while ((row2 = mysql_fetch_row(result2))) {
-					time_t local_start = slurm_atoul(
-						row2[SUSPEND_REQ_START]);
-					time_t local_end = slurm_atoul(
-						row2[SUSPEND_REQ_END]);
+				s = _find_local_suspend(suspends, suspend_cnt,
+							jobs[j].db_inx);
+				for (; (s >= 0) && (s < suspend_cnt)
+					     && (suspends[s].db_inx
+						 == jobs[j].db_inx); s++) {
+					time_t local_start = suspends[s].start;
+					time_t local_end = suspends[s].end;
+
+					if ((local_start >= curr_end)
+					    || (local_end
+						&& (local_end < curr_start)))
+						continue;
 
 					if (!local_start)
 						continue;
@@ -760,7 +874,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 					seconds -= tot_time;
 				}
-				mysql_free_result(result2);
 			}
 			if (seconds < 1) {
 				debug4("This job (%u) was suspended "
@@ -921,7 +1034,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 				}
 			}
 		}
-		mysql_free_result(result);
 
 		/* now figure out how much more to add to the
 		   associations that could had run in the reservation
@@ -1077,8 +1189,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		curr_end = curr_start + add_sec;
 	}
 end_it:
-	xfree(suspend_str);
-	xfree(job_str);
+	xfree(jobs);
+	xfree(suspends);
 	xfree(resv_str);
 	list_iterator_destroy(a_itr);
 	list_iterator_destroy(c_itr);
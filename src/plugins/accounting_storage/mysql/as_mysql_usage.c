@@ -45,6 +45,37 @@ pthread_mutex_t rollup_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_mutex_t usage_rollup_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/* Number of usage query results kept around for reports that ask the
+ * same question over and over again (e.g. dashboards running sreport).
+ */
+#define MAX_USAGE_CACHE 100
+/* Bytes of values kept in the cache altogether, and for one result.
+ * Larger results (e.g. hourly usage of every association over a long
+ * period) are not kept at all. */
+#define MAX_USAGE_CACHE_SIZE		(256 * 1024 * 1024)
+#define MAX_USAGE_CACHE_REC_SIZE	(16 * 1024 * 1024)
+
+/* The result of one usage query.  Every usage column is numeric so the
+ * values are stored a column at a time, rec_cnt values per column.
+ * A result is shared by the cache and everyone reading it, and freed
+ * when the last of them lets go of it.
+ */
+typedef struct {
+	int col_cnt;
+	char *query;
+	int rec_cnt;
+	int ref_cnt;	/* protected by usage_cache_lock */
+	uint64_t *values;
+} usage_cache_t;
+
+/* most recently used first */
+static List usage_cache_list = NULL;
+/* bytes of values held by usage_cache_list */
+static size_t usage_cache_size = 0;
+/* bumped every time the cache is cleared */
+static uint32_t usage_cache_gen = 0;
+static pthread_mutex_t usage_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 typedef struct {
 	uint16_t archive_data;
 	char *cluster_name;
@@ -57,6 +88,144 @@ typedef struct {
 	time_t sent_start;
 } local_rollup_t;
 
+static size_t _usage_cache_size(usage_cache_t *usage_cache)
+{
+	return sizeof(uint64_t) * (size_t)usage_cache->col_cnt
+		* (size_t)usage_cache->rec_cnt;
+}
+
+/* usage_cache_lock must be locked before calling this */
+static void _unref_usage_cache(usage_cache_t *usage_cache)
+{
+	if (!usage_cache || --usage_cache->ref_cnt)
+		return;
+	xfree(usage_cache->query);
+	xfree(usage_cache->values);
+	xfree(usage_cache);
+}
+
+/* Let go of a result returned by _get_usage_query() */
+static void _destroy_usage_cache(usage_cache_t *usage_cache)
+{
+	slurm_mutex_lock(&usage_cache_lock);
+	_unref_usage_cache(usage_cache);
+	slurm_mutex_unlock(&usage_cache_lock);
+}
+
+/* Drop the least recently used results until the cache is within its
+ * limits.  usage_cache_lock must be locked before calling this. */
+static void _trim_usage_cache(void)
+{
+	usage_cache_t *usage_cache;
+	ListIterator itr;
+	size_t size = 0;
+	int cnt = 0;
+
+	if ((list_count(usage_cache_list) <= MAX_USAGE_CACHE)
+	    && (usage_cache_size <= MAX_USAGE_CACHE_SIZE))
+		return;
+
+	/* the list is most recently used first */
+	itr = list_iterator_create(usage_cache_list);
+	while ((usage_cache = list_next(itr))) {
+		if ((cnt < MAX_USAGE_CACHE)
+		    && ((size + _usage_cache_size(usage_cache))
+			<= MAX_USAGE_CACHE_SIZE)) {
+			size += _usage_cache_size(usage_cache);
+			cnt++;
+			continue;
+		}
+		list_remove(itr);
+		_unref_usage_cache(usage_cache);
+	}
+	list_iterator_destroy(itr);
+	usage_cache_size = size;
+}
+
+static inline uint64_t _usage_value(usage_cache_t *usage_cache,
+				    int col, int rec)
+{
+	return usage_cache->values[(col * usage_cache->rec_cnt) + rec];
+}
+
+/* Return the result of a usage query selecting col_cnt numeric columns.
+ * Results are reused until the usage tables change, see
+ * as_mysql_usage_cache_clear().
+ * RET result to be freed with _destroy_usage_cache() or NULL on error
+ */
+static usage_cache_t *_get_usage_query(mysql_conn_t *mysql_conn,
+				       char *query, int col_cnt)
+{
+	usage_cache_t *usage_cache = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	ListIterator itr;
+	uint32_t gen;
+	int i, rec = 0;
+
+	slurm_mutex_lock(&usage_cache_lock);
+	if (usage_cache_list) {
+		itr = list_iterator_create(usage_cache_list);
+		while ((usage_cache = list_next(itr))) {
+			if (!strcmp(usage_cache->query, query)) {
+				list_remove(itr);
+				break;
+			}
+		}
+		list_iterator_destroy(itr);
+		if (usage_cache) {
+			list_prepend(usage_cache_list, usage_cache);
+			usage_cache->ref_cnt++;
+		}
+	}
+	gen = usage_cache_gen;
+	slurm_mutex_unlock(&usage_cache_lock);
+
+	if (usage_cache) {
+		debug4("%d(%s:%d) cached query\n%s",
+		       mysql_conn->conn, THIS_FILE, __LINE__, query);
+		return usage_cache;
+	}
+
+	debug4("%d(%s:%d) query\n%s",
+	       mysql_conn->conn, THIS_FILE, __LINE__, query);
+	if (!(result = mysql_db_query_ret(mysql_conn, query, 0)))
+		return NULL;
+
+	usage_cache = xmalloc(sizeof(usage_cache_t));
+	usage_cache->col_cnt = col_cnt;
+	usage_cache->ref_cnt = 1;
+	usage_cache->query = xstrdup(query);
+	usage_cache->rec_cnt = mysql_num_rows(result);
+	if (usage_cache->rec_cnt)
+		usage_cache->values = xmalloc(sizeof(uint64_t) * col_cnt
+					      * usage_cache->rec_cnt);
+	while ((row = mysql_fetch_row(result))
+	       && (rec < usage_cache->rec_cnt)) {
+		for (i = 0; i < col_cnt; i++)
+			usage_cache->values[(i * usage_cache->rec_cnt) + rec] =
+				slurm_atoull(row[i]);
+		rec++;
+	}
+	mysql_free_result(result);
+
+	slurm_mutex_lock(&usage_cache_lock);
+	/* Don't keep a result that may have been read before the tables
+	 * last changed, or one too big to be worth keeping. */
+	if ((gen == usage_cache_gen)
+	    && (_usage_cache_size(usage_cache) <= MAX_USAGE_CACHE_REC_SIZE)) {
+		if (!usage_cache_list)
+			usage_cache_list = list_create(NULL);
+		list_prepend(usage_cache_list, usage_cache);
+		usage_cache->ref_cnt++;
+		usage_cache_size += _usage_cache_size(usage_cache);
+		_trim_usage_cache();
+	}
+	slurm_mutex_unlock(&usage_cache_lock);
+
+	return usage_cache;
+}
+
 static void *_cluster_rollup_usage(void *arg)
 {
 	local_rollup_t *local_rollup = (local_rollup_t *)arg;
@@ -392,6 +561,7 @@ end_it:
 
 	mysql_db_close_db_connection(&mysql_conn);
 	slurm_mutex_destroy(&mysql_conn.lock);
+	as_mysql_usage_cache_clear();
 
 	slurm_mutex_lock(local_rollup->rolledup_lock);
 	(*local_rollup->rolledup)++;
@@ -412,8 +582,7 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 {
 	int rc = SLURM_SUCCESS;
 	int i=0;
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row;
+	usage_cache_t *usage = NULL;
 	char *tmp = NULL;
 	char *my_usage_table = cluster_day_table;
 	char *query = NULL;
@@ -463,10 +632,7 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 		tmp, cluster_rec->name, my_usage_table, end, start);
 
 	xfree(tmp);
-	debug4("%d(%s:%d) query\n%s",
-	       mysql_conn->conn, THIS_FILE, __LINE__, query);
-	if (!(result = mysql_db_query_ret(
-		      mysql_conn, query, 0))) {
+	if (!(usage = _get_usage_query(mysql_conn, query, CLUSTER_COUNT))) {
 		xfree(query);
 		return SLURM_ERROR;
 	}
@@ -476,20 +642,28 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 		cluster_rec->accounting_list =
 			list_create(slurmdb_destroy_cluster_accounting_rec);
 
-	while ((row = mysql_fetch_row(result))) {
+	for (i = 0; i < usage->rec_cnt; i++) {
 		slurmdb_cluster_accounting_rec_t *accounting_rec =
 			xmalloc(sizeof(slurmdb_cluster_accounting_rec_t));
-		accounting_rec->alloc_secs = slurm_atoull(row[CLUSTER_ACPU]);
-		accounting_rec->down_secs = slurm_atoull(row[CLUSTER_DCPU]);
-		accounting_rec->pdown_secs = slurm_atoull(row[CLUSTER_PDCPU]);
-		accounting_rec->idle_secs = slurm_atoull(row[CLUSTER_ICPU]);
-		accounting_rec->over_secs = slurm_atoull(row[CLUSTER_OCPU]);
-		accounting_rec->resv_secs = slurm_atoull(row[CLUSTER_RCPU]);
-		accounting_rec->cpu_count = slurm_atoul(row[CLUSTER_CPU_COUNT]);
-		accounting_rec->period_start = slurm_atoul(row[CLUSTER_START]);
+		accounting_rec->alloc_secs =
+			_usage_value(usage, CLUSTER_ACPU, i);
+		accounting_rec->down_secs =
+			_usage_value(usage, CLUSTER_DCPU, i);
+		accounting_rec->pdown_secs =
+			_usage_value(usage, CLUSTER_PDCPU, i);
+		accounting_rec->idle_secs =
+			_usage_value(usage, CLUSTER_ICPU, i);
+		accounting_rec->over_secs =
+			_usage_value(usage, CLUSTER_OCPU, i);
+		accounting_rec->resv_secs =
+			_usage_value(usage, CLUSTER_RCPU, i);
+		accounting_rec->cpu_count =
+			(uint32_t)_usage_value(usage, CLUSTER_CPU_COUNT, i);
+		accounting_rec->period_start =
+			(time_t)_usage_value(usage, CLUSTER_START, i);
 		list_append(cluster_rec->accounting_list, accounting_rec);
 	}
-	mysql_free_result(result);
+	_destroy_usage_cache(usage);
 
 	return rc;
 }
@@ -504,15 +678,13 @@ extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 			      char *cluster_name, time_t start, time_t end)
 {
 	int rc = SLURM_SUCCESS;
-	int i=0;
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row;
+	int i=0, added = 0;
+	usage_cache_t *usage = NULL;
 	char *tmp = NULL;
 	char *my_usage_table = NULL;
 	char *query = NULL;
-	List usage_list = NULL;
 	char *id_str = NULL;
-	ListIterator itr = NULL, u_itr = NULL;
+	ListIterator itr = NULL;
 	void *object = NULL;
 	slurmdb_association_rec_t *assoc = NULL;
 	slurmdb_wckey_rec_t *wckey = NULL;
@@ -631,32 +803,14 @@ extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 	xfree(id_str);
 	xfree(tmp);
 
-	debug4("%d(%s:%d) query\n%s",
-	       mysql_conn->conn, THIS_FILE, __LINE__, query);
-	if (!(result = mysql_db_query_ret(
-		      mysql_conn, query, 0))) {
-		xfree(query);
-		return SLURM_ERROR;
-	}
+	usage = _get_usage_query(mysql_conn, query, USAGE_COUNT);
 	xfree(query);
+	if (!usage)
+		return SLURM_ERROR;
 
-	usage_list = list_create(slurmdb_destroy_accounting_rec);
-
-	while ((row = mysql_fetch_row(result))) {
-		slurmdb_accounting_rec_t *accounting_rec =
-			xmalloc(sizeof(slurmdb_accounting_rec_t));
-		accounting_rec->id = slurm_atoul(row[USAGE_ID]);
-		accounting_rec->period_start = slurm_atoul(row[USAGE_START]);
-		accounting_rec->alloc_secs = slurm_atoull(row[USAGE_ACPU]);
-		list_append(usage_list, accounting_rec);
-	}
-	mysql_free_result(result);
-
-	u_itr = list_iterator_create(usage_list);
 	itr = list_iterator_create(object_list);
 	while ((object = list_next(itr))) {
-		int found = 0;
-		int id = 0;
+		int id = 0, lo = 0, hi = usage->rec_cnt;
 		List acct_list = NULL;
 
 		switch (type) {
@@ -681,35 +835,36 @@ extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 			break;
 		}
 
-		while ((accounting_rec = list_next(u_itr))) {
-			if (id == accounting_rec->id) {
-				list_append(acct_list, accounting_rec);
-				list_remove(u_itr);
-				found = 1;
-			} else if (found) {
-				/* here we know the
-				   list is in id order so
-				   if the next record
-				   isn't the correct id
-				   just continue since
-				   there is no reason to
-				   go through the rest of
-				   the list when we know
-				   it isn't going to be
-				   the correct id */
-				break;
-			}
+		/* The records are in id order, so find the first one
+		   for this id and take all that follow with the same
+		   id. */
+		while (lo < hi) {
+			i = (lo + hi) / 2;
+			if (_usage_value(usage, USAGE_ID, i) < id)
+				lo = i + 1;
+			else
+				hi = i;
+		}
+		for (i = lo; (i < usage->rec_cnt)
+			     && (_usage_value(usage, USAGE_ID, i) == id); i++) {
+			accounting_rec =
+				xmalloc(sizeof(slurmdb_accounting_rec_t));
+			accounting_rec->id = id;
+			accounting_rec->period_start =
+				(time_t)_usage_value(usage, USAGE_START, i);
+			accounting_rec->alloc_secs =
+				_usage_value(usage, USAGE_ACPU, i);
+			list_append(acct_list, accounting_rec);
+			added++;
 		}
-		list_iterator_reset(u_itr);
 	}
 	list_iterator_destroy(itr);
-	list_iterator_destroy(u_itr);
 
-	if (list_count(usage_list))
+	if (added < usage->rec_cnt)
 		error("we have %d records not added "
 		      "to the association list",
-		      list_count(usage_list));
-	list_destroy(usage_list);
+		      usage->rec_cnt - added);
+	_destroy_usage_cache(usage);
 
 
 	return rc;
@@ -721,8 +876,7 @@ extern int as_mysql_get_usage(mysql_conn_t *mysql_conn, uid_t uid,
 {
 	int rc = SLURM_SUCCESS;
 	int i=0, is_admin=1;
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row;
+	usage_cache_t *usage = NULL;
 	char *tmp = NULL;
 	char *my_usage_table = NULL;
 	slurmdb_association_rec_t *slurmdb_assoc = in;
@@ -884,31 +1038,47 @@ is_user:
 	}
 
 	xfree(tmp);
-	debug4("%d(%s:%d) query\n%s",
-	       mysql_conn->conn, THIS_FILE, __LINE__, query);
-	if (!(result = mysql_db_query_ret(
-		      mysql_conn, query, 0))) {
-		xfree(query);
-		return SLURM_ERROR;
-	}
+	usage = _get_usage_query(mysql_conn, query, USAGE_COUNT);
 	xfree(query);
+	if (!usage)
+		return SLURM_ERROR;
 
 	if (!(*my_list))
 		(*my_list) = list_create(slurmdb_destroy_accounting_rec);
 
-	while ((row = mysql_fetch_row(result))) {
+	for (i = 0; i < usage->rec_cnt; i++) {
 		slurmdb_accounting_rec_t *accounting_rec =
 			xmalloc(sizeof(slurmdb_accounting_rec_t));
-		accounting_rec->id = slurm_atoul(row[USAGE_ID]);
-		accounting_rec->period_start = slurm_atoul(row[USAGE_START]);
-		accounting_rec->alloc_secs = slurm_atoull(row[USAGE_ACPU]);
+		accounting_rec->id =
+			(uint32_t)_usage_value(usage, USAGE_ID, i);
+		accounting_rec->period_start =
+			(time_t)_usage_value(usage, USAGE_START, i);
+		accounting_rec->alloc_secs =
+			_usage_value(usage, USAGE_ACPU, i);
 		list_append((*my_list), accounting_rec);
 	}
-	mysql_free_result(result);
+	_destroy_usage_cache(usage);
 
 	return rc;
 }
 
+/* Forget all cached usage query results.  Call whenever the usage
+ * tables, or the associations usage is summed over, may have changed.
+ */
+extern void as_mysql_usage_cache_clear(void)
+{
+	usage_cache_t *usage_cache;
+
+	slurm_mutex_lock(&usage_cache_lock);
+	usage_cache_gen++;
+	if (usage_cache_list) {
+		while ((usage_cache = list_pop(usage_cache_list)))
+			_unref_usage_cache(usage_cache);
+	}
+	usage_cache_size = 0;
+	slurm_mutex_unlock(&usage_cache_lock);
+}
+
 extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn,
 			       time_t sent_start, time_t sent_end,
 			       uint16_t archive_data)
@@ -51,6 +51,7 @@ extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 extern int as_mysql_get_usage(mysql_conn_t *mysql_conn, uid_t uid,
 			  void *in, slurmdbd_msg_type_t type,
 			  time_t start, time_t end);
+extern void as_mysql_usage_cache_clear(void);
 extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn,
 			    time_t sent_start, time_t sent_end,
 			    uint16_t archive_data);
@@ -326,6 +326,11 @@ extern int acct_storage_p_commit(pgsql_conn_t *pg_conn, bool commit)
 	return rc;
 }
 
+extern int acct_storage_p_batch(pgsql_conn_t *pg_conn, bool start)
+{
+	return SLURM_SUCCESS;
+}
+
 extern int acct_storage_p_add_users(pgsql_conn_t *pg_conn, uint32_t uid,
 				    List user_list)
 {
@@ -488,6 +488,12 @@ extern int acct_storage_p_commit(void *db_conn, bool commit)
 	return rc;
 }
 
+extern int acct_storage_p_batch(void *db_conn, bool start)
+{
+	/* The slurmdbd batches the records it stores itself */
+	return SLURM_SUCCESS;
+}
+
 extern int acct_storage_p_add_users(void *db_conn, uint32_t uid,
 				    List user_list)
 {
@@ -40,6 +40,7 @@
 #endif
 
 #include <stdlib.h>
+#include <sys/uio.h>
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/xmalloc.h"
@@ -532,18 +533,38 @@ client_resp_new(void)
 	return resp;
 }
 
+/*
+ * For PMI2 the length header and the body go out in one writev() so the
+ * client is woken once per response rather than once for each part.
+ */
 extern int
 client_resp_send(client_resp_t *resp, int fd)
 {
 	char len_buf[7];
-	int len;
+	struct iovec iov[2];
+	int len, n;
 
 	len = strlen(resp->buf);
 
 	if ( is_pmi20() ) {
 		snprintf(len_buf, 7, "%-6d", len);
 		debug2("mpi/pmi2: client_resp_send: %s%s", len_buf, resp->buf);
-		safe_write(fd, len_buf, 6);
+		iov[0].iov_base = len_buf;
+		iov[0].iov_len  = 6;
+		iov[1].iov_base = resp->buf;
+		iov[1].iov_len  = len;
+		while (((n = writev(fd, iov, 2)) < 0) &&
+		       ((errno == EINTR) || (errno == EAGAIN)));
+		if (n < 0)
+			goto rwfail;
+		/* finish a short write */
+		if (n < 6) {
+			safe_write(fd, len_buf + n, 6 - n);
+			n = 6;
+		}
+		if (n - 6 < len)
+			safe_write(fd, resp->buf + (n - 6), len - (n - 6));
+		return SLURM_SUCCESS;
 	} else if ( is_pmi11() ) {
 		debug2("mpi/pmi2: client_resp_send: %s", resp->buf);
 	}
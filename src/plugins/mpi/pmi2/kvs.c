@@ -57,9 +57,7 @@ typedef struct kvs_bucket {
 static kvs_bucket_t *kvs_hash = NULL;
 static uint32_t hash_size = 0;
 
-static char *temp_kvs_buf = NULL;
-static int temp_kvs_cnt = 0;
-static int temp_kvs_size = 0;
+static Buf temp_kvs_buf = NULL;
 
 static int no_dup_keys = 0;
 
@@ -70,32 +68,46 @@ static int no_dup_keys = 0;
 #define VAL_INDEX(i) (i * 2 + 1)
 #define HASH(key) ( _hash(key) % hash_size)
 
+/*
+ * FNV-1a. Keys are typically a common prefix plus a rank number, which
+ * a byte-rotating hash spreads unevenly, leaving many buckets empty and
+ * lengthening the chains searched by kvs_put() and kvs_get().
+ */
 inline static uint32_t
 _hash(char *key)
 {
-	int len, i;
-	uint32_t hash = 0;
-	uint8_t shift;
-
-	len = strlen(key);
-	for (i = 0; i < len; i ++) {
-		shift = (uint8_t)(hash >> 24);
-		hash = (hash << 8) | (uint32_t)(shift ^ (uint8_t)key[i]);
+	uint32_t hash = 2166136261U;
+
+	while (*key) {
+		hash ^= (uint8_t) *key++;
+		hash *= 16777619U;
 	}
 	return hash;
 }
 
+/*
+ * Make room for at least size more bytes in temp_kvs_buf. The buffer
+ * doubles so that accumulating a large fence costs linear time.
+ */
+static void
+_temp_kvs_reserve(uint32_t size)
+{
+	if (remaining_buf(temp_kvs_buf) >= size)
+		return;
+	grow_buf(temp_kvs_buf, MAX(size, size_buf(temp_kvs_buf)));
+}
+
 extern int
 temp_kvs_init(void)
 {
 	uint16_t cmd;
-	uint32_t nodeid, num_children, size;
-	Buf buf = NULL;
-	
-	xfree(temp_kvs_buf);
-	temp_kvs_cnt = 0;
-	temp_kvs_size = TEMP_KVS_SIZE_INC;
-	temp_kvs_buf = xmalloc(temp_kvs_size);
+	uint32_t nodeid, num_children;
+
+	/* the buffer is kept across fences, only its contents go */
+	if (temp_kvs_buf == NULL)
+		temp_kvs_buf = init_buf(TEMP_KVS_SIZE_INC);
+	else
+		set_buf_offset(temp_kvs_buf, 0);
 
 	/* put the tree cmd here to simplify message sending */
 	if (in_stepd()) {
@@ -104,25 +116,16 @@ temp_kvs_init(void)
 		cmd = TREE_CMD_KVS_FENCE_RESP;
 	}
 
-	buf = init_buf(1024);
-	pack16(cmd, buf);
+	pack16(cmd, temp_kvs_buf);
 	if (in_stepd()) {
 		nodeid = job_info.nodeid;
 		/* XXX: TBC */
 		num_children = tree_info.num_children + 1;
 		
-		pack32((uint32_t)nodeid, buf); /* from_nodeid */
-		packstr(tree_info.this_node, buf); /* from_node */
-		pack32((uint32_t)num_children, buf); /* num_children */
+		pack32((uint32_t)nodeid, temp_kvs_buf); /* from_nodeid */
+		packstr(tree_info.this_node, temp_kvs_buf); /* from_node */
+		pack32((uint32_t)num_children, temp_kvs_buf); /* num_children */
 	}
-	size = get_buf_offset(buf);
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += TEMP_KVS_SIZE_INC;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], get_buf_data(buf), size);
-	temp_kvs_cnt += size;
-	free_buf(buf);
 
 	tasks_to_wait = 0;
 	children_to_wait = 0;
@@ -130,27 +133,24 @@ temp_kvs_init(void)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Append a key-value pair to the fence buffer, packing straight into
+ * it rather than through an intermediate Buf.
+ */
 extern int
 temp_kvs_add(char *key, char *val)
 {
-	Buf buf;
-	uint32_t size;
-	
+	uint32_t key_len, val_len;
+
 	if ( key == NULL || val == NULL )
 		return SLURM_SUCCESS;
 
-	buf = init_buf(PMI2_MAX_KEYLEN + PMI2_MAX_VALLEN + 2 * sizeof(uint32_t));
-	packstr(key, buf);
-	packstr(val, buf);
-	size = get_buf_offset(buf);
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += TEMP_KVS_SIZE_INC;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], get_buf_data(buf), size);
-	temp_kvs_cnt += size;
-	free_buf(buf);
-	
+	key_len = strlen(key) + 1;
+	val_len = strlen(val) + 1;
+	_temp_kvs_reserve(key_len + val_len + 2 * sizeof(uint32_t));
+	packmem(key, key_len, temp_kvs_buf);
+	packmem(val, val_len, temp_kvs_buf);
+
 	return SLURM_SUCCESS;
 }
 
@@ -167,12 +167,10 @@ temp_kvs_merge(Buf buf)
 	data = get_buf_data(buf);
 	offset = get_buf_offset(buf);
 
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += size;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], &data[offset], size);
-	temp_kvs_cnt += size;
+	_temp_kvs_reserve(size);
+	memcpy(&get_buf_data(temp_kvs_buf)[get_buf_offset(temp_kvs_buf)],
+	       &data[offset], size);
+	set_buf_offset(temp_kvs_buf, get_buf_offset(temp_kvs_buf) + size);
 	
 	return SLURM_SUCCESS;
 }
@@ -186,15 +184,16 @@ temp_kvs_send(void)
 	
 	if (! in_stepd()) {	/* srun */
 		rc = tree_msg_to_stepds(job_info.step_nodelist,
-					temp_kvs_cnt,
-					temp_kvs_buf);
+					get_buf_offset(temp_kvs_buf),
+					get_buf_data(temp_kvs_buf));
 	} else if (tree_info.parent_node != NULL) {
 		/* non-first-level stepds */
 		rc = tree_msg_to_stepds(tree_info.parent_node,
-					temp_kvs_cnt,
-					temp_kvs_buf);
+					get_buf_offset(temp_kvs_buf),
+					get_buf_data(temp_kvs_buf));
 	} else {		/* first level stepds */
-		rc = tree_msg_to_srun(temp_kvs_cnt, temp_kvs_buf);
+		rc = tree_msg_to_srun(get_buf_offset(temp_kvs_buf),
+				      get_buf_data(temp_kvs_buf));
 	}
 
 	temp_kvs_init();	/* clear old temp kvs */
@@ -292,7 +292,10 @@ _handle_get(int fd, int lrank, client_req_t *req)
 	client_req_get_str(req, KVSNAME_KEY, &kvsname); /* not used */
 	client_req_get_str(req, KEY_KEY, &key);
 	
-	val = kvs_get(key);
+	if (key)
+		val = kvs_get(key);
+	xfree(kvsname);
+	xfree(key);
 
 	resp = client_resp_new();
 	if (val != NULL) {
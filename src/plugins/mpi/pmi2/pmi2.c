@@ -268,14 +268,16 @@ _handle_kvs_get(int fd, int lrank, client_req_t *req)
 {
 	int rc;
 	client_resp_t *resp;
-	char *key, *val;
+	char *key = NULL, *val = NULL;
 
 	debug3("mpi/pmi2: in _handle_kvs_get");
 	
 	client_req_parse_body(req);
 	client_req_get_str(req, KEY_KEY, &key);
 	
-	val = kvs_get(key);
+	if (key)
+		val = kvs_get(key);
+	xfree(key);
 
 	resp = client_resp_new();
 	if (val != NULL) {
@@ -117,14 +117,13 @@ _handle_kvs_fence_resp(int fd, Buf buf)
 	debug3("mpi/pmi2: in _handle_kvs_fence_resp");
 	temp32 = remaining_buf(buf);
 	debug3("mpi/pmi2: buf length: %u", temp32);
-	/* put kvs into local hash */
+	/* put kvs into local hash. The strings are NUL terminated in
+	 * the buffer, so reference them in place; kvs_put() copies them */
 	while (remaining_buf(buf) > 0) {
-		safe_unpackstr_xmalloc(&key, &temp32, buf);
-		safe_unpackstr_xmalloc(&val, &temp32, buf);
-		kvs_put(key, val);
-		//temp32 = remaining_buf(buf);
-		xfree(key);
-		xfree(val);
+		safe_unpackmem_ptr(&key, &temp32, buf);
+		safe_unpackmem_ptr(&val, &temp32, buf);
+		if (key && val)
+			kvs_put(key, val);
 	}
 
 resp:
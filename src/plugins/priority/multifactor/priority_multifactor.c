@@ -66,6 +66,13 @@
 
 #define SECS_PER_DAY	(24 * 60 * 60)
 #define SECS_PER_WEEK	(7 * SECS_PER_DAY)
+
+/* The decay thread splits the priority sweep of pending jobs over
+ * up to MAX_PRIO_THREADS threads, each given at least
+ * MIN_PRIO_JOBS_PER_THREAD jobs.  Smaller queues are done inline.
+ */
+#define MAX_PRIO_THREADS		8
+#define MIN_PRIO_JOBS_PER_THREAD	10000
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
  * overwritten when linking with the slurmctld.
@@ -130,6 +137,25 @@ static uint32_t weight_part; /* weight for Partition factor */
 static uint32_t weight_qos; /* weight for QOS factor */
 static uint32_t flags;      /* Priority Flags */
 
+/* Pending jobs gathered by the decay thread for the priority sweep,
+ * kept as parallel arrays and reused from cycle to cycle */
+typedef struct {
+	struct job_record **job;	/* job to set the priority of */
+	double *fs;			/* its fairshare factor */
+	uint32_t *prio;			/* its new priority */
+	int cnt;			/* jobs gathered this cycle */
+	int size;			/* allocated length of the arrays */
+} prio_sweep_t;
+
+typedef struct {
+	prio_sweep_t *sweep;
+	time_t start_time;
+	int begin;
+	int end;
+} prio_sweep_args_t;
+
+static prio_sweep_t prio_sweep;
+
 extern void priority_p_set_assoc_usage(slurmdb_association_rec_t *assoc);
 extern double priority_p_calc_fs_factor(long double usage_efctv,
 					long double shares_norm);
@@ -393,10 +419,32 @@ static int _set_children_usage_efctv(List childern_list)
 	return SLURM_SUCCESS;
 }
 
+/* Forget the fairshare factors cached during the last decay cycle.
+ * NOTE: assoc_mgr association write lock must be held.
+ */
+static void _clear_fs_factors(void)
+{
+	ListIterator itr = NULL;
+	slurmdb_association_rec_t *assoc = NULL;
+
+	if (!assoc_mgr_association_list)
+		return;
+
+	itr = list_iterator_create(assoc_mgr_association_list);
+	while ((assoc = list_next(itr)))
+		assoc->usage->fs_factor = (double)NO_VAL;
+	list_iterator_destroy(itr);
+}
+
 /* job_ptr should already have the partition priority and such added
  * here before had we will be adding to it
+ *
+ * If locked is set the caller holds the assoc_mgr association write
+ * lock for the whole decay cycle, so the factor of each association
+ * is only calculated once and cached in its usage.
  */
-static double _get_fairshare_priority( struct job_record *job_ptr)
+static double _get_fairshare_priority(struct job_record *job_ptr,
+				      bool locked)
 {
 	slurmdb_association_rec_t *job_assoc =
 		(slurmdb_association_rec_t *)job_ptr->assoc_ptr;
@@ -416,7 +464,8 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 
 	fs_assoc = job_assoc;
 
-	assoc_mgr_lock(&locks);
+	if (!locked)
+		assoc_mgr_lock(&locks);
 
 	/* Use values from parent when FairShare=SLURMDB_FS_USE_PARENT */
 	while ((fs_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
@@ -425,13 +474,19 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 		fs_assoc = fs_assoc->usage->parent_assoc_ptr;
 	}
 
-	if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
-		priority_p_set_assoc_usage(fs_assoc);
-
-	/* Priority is 0 -> 1 */
-	priority_fs = priority_p_calc_fs_factor(
-		fs_assoc->usage->usage_efctv,
-		(long double)fs_assoc->usage->shares_norm);
+	if (locked && !fuzzy_equal(fs_assoc->usage->fs_factor, NO_VAL)) {
+		priority_fs = fs_assoc->usage->fs_factor;
+	} else {
+		if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
+			priority_p_set_assoc_usage(fs_assoc);
+
+		/* Priority is 0 -> 1 */
+		priority_fs = priority_p_calc_fs_factor(
+			fs_assoc->usage->usage_efctv,
+			(long double)fs_assoc->usage->shares_norm);
+		if (locked)
+			fs_assoc->usage->fs_factor = priority_fs;
+	}
 	if (priority_debug) {
 		info("Fairshare priority of job %u for user %s in acct"
 		     " %s is 2**(-%Lf/%f) = %f",
@@ -440,12 +495,14 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 		     fs_assoc->usage->shares_norm, priority_fs);
 	}
 
-	assoc_mgr_unlock(&locks);
+	if (!locked)
+		assoc_mgr_unlock(&locks);
 
 	return priority_fs;
 }
 
-static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
+static void _get_priority_factors(time_t start_time, struct job_record *job_ptr,
+				  double priority_fs)
 {
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 
@@ -490,10 +547,8 @@ static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
 		}
 	}
 
-	if (job_ptr->assoc_ptr && weight_fs) {
-		job_ptr->prio_factors->priority_fs =
-			_get_fairshare_priority(job_ptr);
-	}
+	if (job_ptr->assoc_ptr && weight_fs)
+		job_ptr->prio_factors->priority_fs = priority_fs;
 
 	if (weight_js) {
 		uint32_t cpu_cnt = 0;
@@ -549,24 +604,18 @@ static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
 	job_ptr->prio_factors->nice = job_ptr->details->nice;
 }
 
-static uint32_t _get_priority_internal(time_t start_time,
-				       struct job_record *job_ptr)
+/* Weigh the factors of a job into its priority given its already
+ * computed fairshare factor.  This only touches the job itself, so it
+ * is safe to run on different jobs in parallel.
+ */
+static uint32_t _calc_priority(time_t start_time, struct job_record *job_ptr,
+			       double priority_fs)
 {
 	double priority		= 0.0;
 	priority_factors_object_t pre_factors;
 
-	if (job_ptr->direct_set_prio && (job_ptr->priority > 0))
-		return job_ptr->priority;
-
-	if (!job_ptr->details) {
-		error("_get_priority_internal: job %u does not have a "
-		      "details symbol set, can't set priority",
-		      job_ptr->job_id);
-		return 0;
-	}
-
 	/* figure out the priority */
-	_get_priority_factors(start_time, job_ptr);
+	_get_priority_factors(start_time, job_ptr, priority_fs);
 	memcpy(&pre_factors, job_ptr->prio_factors,
 	       sizeof(priority_factors_object_t));
 
@@ -616,6 +665,117 @@ static uint32_t _get_priority_internal(time_t start_time,
 	return (uint32_t)priority;
 }
 
+/* Return 1 if the priority of the job is to be calculated from its
+ * factors, 0 if it is set elsewhere or can't be calculated. */
+static int _calc_priority_set(struct job_record *job_ptr)
+{
+	if (job_ptr->direct_set_prio && (job_ptr->priority > 0))
+		return 0;
+	if (!job_ptr->details)
+		return 0;
+	return 1;
+}
+
+static uint32_t _get_priority_internal(time_t start_time,
+				       struct job_record *job_ptr,
+				       bool assoc_locked)
+{
+	double priority_fs = 0.0;
+
+	if (job_ptr->direct_set_prio && (job_ptr->priority > 0))
+		return job_ptr->priority;
+
+	if (!job_ptr->details) {
+		error("_get_priority_internal: job %u does not have a "
+		      "details symbol set, can't set priority",
+		      job_ptr->job_id);
+		return 0;
+	}
+
+	if (job_ptr->assoc_ptr && weight_fs)
+		priority_fs = _get_fairshare_priority(job_ptr, assoc_locked);
+
+	return _calc_priority(start_time, job_ptr, priority_fs);
+}
+
+/* Add a pending job to the priority sweep of this decay cycle.
+ * NOTE: assoc_mgr association write lock must be held.
+ */
+static void _prio_sweep_add(prio_sweep_t *sweep, struct job_record *job_ptr)
+{
+	if (sweep->cnt >= sweep->size) {
+		sweep->size = MAX(sweep->size * 2, 1024);
+		xrealloc(sweep->job, sizeof(struct job_record *) * sweep->size);
+		xrealloc(sweep->fs, sizeof(double) * sweep->size);
+		xrealloc(sweep->prio, sizeof(uint32_t) * sweep->size);
+	}
+
+	/* The fairshare factor comes from the association tree and
+	 * is cached there, so it is gathered here in job list order
+	 * rather than in the parallel part of the sweep. */
+	sweep->fs[sweep->cnt] = 0.0;
+	if (job_ptr->assoc_ptr && weight_fs)
+		sweep->fs[sweep->cnt] = _get_fairshare_priority(job_ptr, true);
+	sweep->job[sweep->cnt++] = job_ptr;
+}
+
+static void *_prio_sweep_range(void *arg)
+{
+	prio_sweep_args_t *args = (prio_sweep_args_t *) arg;
+	prio_sweep_t *sweep = args->sweep;
+	int i;
+
+	for (i = args->begin; i < args->end; i++)
+		sweep->prio[i] = _calc_priority(args->start_time,
+						sweep->job[i], sweep->fs[i]);
+	return NULL;
+}
+
+/* Calculate the new priority of every job gathered in the sweep,
+ * splitting the work over several threads for large queues.
+ */
+static void _prio_sweep_run(prio_sweep_t *sweep, time_t start_time)
+{
+	prio_sweep_args_t args[MAX_PRIO_THREADS];
+	pthread_t threads[MAX_PRIO_THREADS];
+	pthread_attr_t thread_attr;
+	int i, thread_cnt, per_thread;
+
+	thread_cnt = sweep->cnt / MIN_PRIO_JOBS_PER_THREAD;
+	if (thread_cnt > MAX_PRIO_THREADS)
+		thread_cnt = MAX_PRIO_THREADS;
+	if (thread_cnt < 1)
+		thread_cnt = 1;
+	per_thread = (sweep->cnt + thread_cnt - 1) / thread_cnt;
+
+	for (i = 0; i < thread_cnt; i++) {
+		args[i].sweep = sweep;
+		args[i].start_time = start_time;
+		args[i].begin = MIN(i * per_thread, sweep->cnt);
+		args[i].end = MIN((i + 1) * per_thread, sweep->cnt);
+		threads[i] = 0;
+	}
+
+	/* The first range is always done by this thread */
+	slurm_attr_init(&thread_attr);
+	for (i = 1; i < thread_cnt; i++) {
+		if (pthread_create(&threads[i], &thread_attr,
+				   _prio_sweep_range, &args[i])) {
+			error("pthread_create error %m");
+			threads[i] = 0;
+			_prio_sweep_range(&args[i]);
+		}
+	}
+	slurm_attr_destroy(&thread_attr);
+
+	_prio_sweep_range(&args[0]);
+
+	for (i = 1; i < thread_cnt; i++) {
+		if (threads[i])
+			pthread_join(threads[i], NULL);
+	}
+}
+
 /* based upon the last reset time, compute when the next reset should be */
 static time_t _next_reset(uint16_t reset_period, time_t last_reset)
 {
@@ -763,6 +923,7 @@ void _init_grp_used_cpu_run_secs(time_t last_ran)
 }
 
 /* If the job is running then apply decay to the job.
+ * NOTE: assoc_mgr association and qos write locks must be held.
  *
  * Return 0 if we don't need to process the job any further, 1 if
  * futher processing is needed.
@@ -775,21 +936,13 @@ static int _apply_new_usage(struct job_record *job_ptr, double decay_factor,
 	double run_delta = 0.0, run_decay = 0.0, real_decay = 0.0;
 	uint64_t cpu_run_delta = 0;
 	uint64_t job_time_limit_ends = 0;
-	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
-				   WRITE_LOCK, NO_LOCK, NO_LOCK };
-	assoc_mgr_lock_t qos_read_lock = { NO_LOCK, NO_LOCK,
-					   READ_LOCK, NO_LOCK, NO_LOCK };
 
 	/* If usage_factor is 0 just skip this
 	   since we don't add the usage.
 	*/
-	assoc_mgr_lock(&qos_read_lock);
 	qos = (slurmdb_qos_rec_t *)job_ptr->qos_ptr;
-	if (qos && !qos->usage_factor) {
-		assoc_mgr_unlock(&qos_read_lock);
+	if (qos && !qos->usage_factor)
 		return 0;
-	}
-	assoc_mgr_unlock(&qos_read_lock);
 
 	if (job_ptr->start_time > start_period)
 		start_period = job_ptr->start_time;
@@ -835,13 +988,6 @@ static int _apply_new_usage(struct job_record *job_ptr, double decay_factor,
 
 	real_decay = run_decay * (double)job_ptr->total_cpus;
 
-	assoc_mgr_lock(&locks);
-	/* Just to make sure we don't make a
-	   window where the qos_ptr could of
-	   changed make sure we get it again
-	   here.
-	*/
-	qos = (slurmdb_qos_rec_t *)job_ptr->qos_ptr;
 	assoc = (slurmdb_association_rec_t *)job_ptr->assoc_ptr;
 
 	/* now apply the usage factor for this qos */
@@ -911,7 +1057,6 @@ static int _apply_new_usage(struct job_record *job_ptr, double decay_factor,
 			     assoc->usage->grp_used_cpu_run_secs/60);
 		assoc = assoc->usage->parent_assoc_ptr;
 	}
-	assoc_mgr_unlock(&locks);
 	return 1;
 }
 
@@ -932,6 +1077,11 @@ static void *_decay_thread(void *no_data)
 		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
+	/* Write lock on assocs and qos, held for the whole job loop */
+	assoc_mgr_lock_t usage_locks = { WRITE_LOCK, NO_LOCK,
+					 WRITE_LOCK, NO_LOCK, NO_LOCK };
+	uint32_t new_prio;
+	int i;
 
 	if (decay_hl > 0)
 		decay_factor = 1 - (0.693 / decay_hl);
@@ -1029,6 +1179,13 @@ static void *_decay_thread(void *no_data)
 			break;
 		}
 		lock_slurmctld(job_write_lock);
+		/* Take the association locks once for the whole cycle
+		 * instead of once per job.  Fairshare factors are
+		 * cached per association below, so they are only
+		 * valid while these locks are held.
+		 */
+		assoc_mgr_lock(&usage_locks);
+		_clear_fs_factors();
 		itr = list_iterator_create(job_list);
 		while ((job_ptr = list_next(itr))) {
 			/* apply new usage */
@@ -1047,13 +1204,37 @@ static void *_decay_thread(void *no_data)
 			    || !IS_JOB_PENDING(job_ptr))
 				continue;
 
-			job_ptr->priority =
-				_get_priority_internal(start_time, job_ptr);
-			last_job_update = time(NULL);
+			if (_calc_priority_set(job_ptr)) {
+				_prio_sweep_add(&prio_sweep, job_ptr);
+				continue;
+			}
+
+			new_prio = _get_priority_internal(start_time, job_ptr,
+							  true);
+			/* Only flag the job list as changed when it was */
+			if (new_prio != job_ptr->priority) {
+				job_ptr->priority = new_prio;
+				last_job_update = time(NULL);
+			}
 			debug2("priority for job %u is now %u",
 			       job_ptr->job_id, job_ptr->priority);
 		}
 		list_iterator_destroy(itr);
+
+		/* Now weigh the factors of all the gathered jobs and
+		 * hand the new priorities back to them */
+		_prio_sweep_run(&prio_sweep, start_time);
+		for (i = 0; i < prio_sweep.cnt; i++) {
+			job_ptr = prio_sweep.job[i];
+			if (prio_sweep.prio[i] != job_ptr->priority) {
+				job_ptr->priority = prio_sweep.prio[i];
+				last_job_update = time(NULL);
+			}
+			debug2("priority for job %u is now %u",
+			       job_ptr->job_id, job_ptr->priority);
+		}
+		prio_sweep.cnt = 0;
+		assoc_mgr_unlock(&usage_locks);
 		unlock_slurmctld(job_write_lock);
 
 	get_usage:
@@ -1235,6 +1416,11 @@ int fini ( void )
 	if (cleanup_handler_thread)
 		pthread_join(cleanup_handler_thread, NULL);
 
+	xfree(prio_sweep.job);
+	xfree(prio_sweep.fs);
+	xfree(prio_sweep.prio);
+	prio_sweep.cnt = prio_sweep.size = 0;
+
 	slurm_mutex_unlock(&decay_lock);
 
 	return SLURM_SUCCESS;
@@ -1242,7 +1428,7 @@ int fini ( void )
 
 extern uint32_t priority_p_set(uint32_t last_prio, struct job_record *job_ptr)
 {
-	uint32_t priority = _get_priority_internal(time(NULL), job_ptr);
+	uint32_t priority = _get_priority_internal(time(NULL), job_ptr, false);
 
 	debug2("initial priority for job %u is %u", job_ptr->job_id, priority);
 
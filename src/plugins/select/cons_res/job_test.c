@@ -1322,6 +1322,58 @@ fini:	xfree(consec_cpus);
 	return error_code;
 }
 
+/*
+ * Accumulate the CPUs usable by the job on every switch. CPUs are only
+ * counted node by node on leaf switches, higher level switches sum the
+ * counts of their direct descendent switches, so each node is visited once
+ * rather than once per switch level. A switch whose descendents overlap
+ * (nodes on multiple leaf switches) is counted from its own bitmap.
+ * NOTE: The logic here is identical to that of _get_switches_cpu_cnt()
+ *       in select_linear.c. Any bug found here is probably also there.
+ */
+static void _get_switches_cpu_cnt(struct job_record *job_ptr,
+				  bitstr_t **switches_bitmap,
+				  int *switches_node_cnt,
+				  int *switches_cpu_cnt, uint16_t *cpu_cnt)
+{
+	struct switch_record *switch_ptr;
+	int i, j, k, level, child_nodes, first, last;
+
+	for (level = 0; level <= switch_levels; level++) {
+		switch_ptr = switch_record_table;
+		for (j=0; j<switch_record_cnt; j++, switch_ptr++) {
+			if (switch_ptr->level != level)
+				continue;
+			switches_cpu_cnt[j] = 0;
+			if (switches_node_cnt[j] == 0)
+				continue;
+			child_nodes = 0;
+			for (k=0; k<switch_ptr->num_switches; k++) {
+				child_nodes += switches_node_cnt[
+					switch_ptr->switch_index[k]];
+			}
+			if (switch_ptr->num_switches &&
+			    (child_nodes == switches_node_cnt[j])) {
+				for (k=0; k<switch_ptr->num_switches; k++) {
+					switches_cpu_cnt[j] += switches_cpu_cnt[
+						switch_ptr->switch_index[k]];
+				}
+				continue;
+			}
+			first = bit_ffs(switches_bitmap[j]);
+			if (first < 0)
+				continue;
+			last  = bit_fls(switches_bitmap[j]);
+			for (i=first; i<=last; i++) {
+				if (!bit_test(switches_bitmap[j], i))
+					continue;
+				switches_cpu_cnt[j] +=
+					_get_cpu_cnt(job_ptr, i, cpu_cnt);
+			}
+		}
+	}
+}
+
 /*
  * A network topology aware version of _eval_nodes().
  * NOTE: The logic here is almost identical to that of _job_test_topo()
@@ -1487,39 +1539,14 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 		for (j=0; j<switch_record_cnt; j++) {
 			if (switches_node_cnt[j] == 0)
 				continue;
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i=first; i<=last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				if (!bit_test(avail_nodes_bitmap, i)) {
-					/* cleared from lower level */
-					bit_clear(switches_bitmap[j], i);
-					switches_node_cnt[j]--;
-				} else {
-					switches_cpu_cnt[j] +=
-						_get_cpu_cnt(job_ptr, i,
-							     cpu_cnt);
-				}
-			}
-		}
-	} else {
-		/* No specific required nodes, calculate CPU counts */
-		for (j=0; j<switch_record_cnt; j++) {
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i=first; i<=last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				switches_cpu_cnt[j] +=
-					_get_cpu_cnt(job_ptr, i, cpu_cnt);
-			}
+			/* clear nodes already taken from a lower level */
+			bit_and(switches_bitmap[j], avail_nodes_bitmap);
+			switches_node_cnt[j] = bit_set_count(switches_bitmap[j]);
 		}
 	}
+	/* Calculate CPU counts */
+	_get_switches_cpu_cnt(job_ptr, switches_bitmap, switches_node_cnt,
+			      switches_cpu_cnt, cpu_cnt);
 
 	/* Determine lowest level switch satisfying request with best fit 
 	 * in respect of the specific required nodes if specified
@@ -94,6 +94,7 @@ int node_record_count __attribute__((weak_import));
 time_t last_node_update __attribute__((weak_import));
 struct switch_record *switch_record_table __attribute__((weak_import));
 int switch_record_cnt __attribute__((weak_import));
+int switch_levels __attribute__((weak_import));
 #else
 slurm_ctl_conf_t slurmctld_conf;
 struct node_record *node_record_table_ptr;
@@ -103,6 +104,7 @@ int node_record_count;
 time_t last_node_update;
 struct switch_record *switch_record_table;
 int switch_record_cnt;
+int switch_levels;
 #endif
 
 struct select_nodeinfo {
@@ -1041,6 +1043,61 @@ static int _job_test(struct job_record *job_ptr, bitstr_t *bitmap,
 	return error_code;
 }
 
+/*
+ * Accumulate the CPUs usable by the job on every switch. CPUs are only
+ * counted node by node on leaf switches, higher level switches sum the
+ * counts of their direct descendent switches, so each node is visited once
+ * rather than once per switch. A switch whose descendents overlap (nodes on
+ * multiple leaf switches) is counted from its own bitmap.
+ * NOTE: The logic here is identical to that of _get_switches_cpu_cnt() in
+ *       select/cons_res/job_test.c. Any bug found here is probably also there.
+ */
+static void _get_switches_cpu_cnt(struct job_record *job_ptr,
+				  bitstr_t **switches_bitmap,
+				  int *switches_cpu_cnt)
+{
+	struct switch_record *switch_ptr;
+	int *switches_set_cnt;
+	int i, j, k, level, child_nodes, first, last;
+
+	switches_set_cnt = xmalloc(sizeof(int) * switch_record_cnt);
+	for (j=0; j<switch_record_cnt; j++)
+		switches_set_cnt[j] = bit_set_count(switches_bitmap[j]);
+
+	for (level = 0; level <= switch_levels; level++) {
+		switch_ptr = switch_record_table;
+		for (j=0; j<switch_record_cnt; j++, switch_ptr++) {
+			if (switch_ptr->level != level)
+				continue;
+			switches_cpu_cnt[j] = 0;
+			child_nodes = 0;
+			for (k=0; k<switch_ptr->num_switches; k++) {
+				child_nodes += switches_set_cnt[
+					switch_ptr->switch_index[k]];
+			}
+			if (switch_ptr->num_switches &&
+			    (child_nodes == switches_set_cnt[j])) {
+				for (k=0; k<switch_ptr->num_switches; k++) {
+					switches_cpu_cnt[j] += switches_cpu_cnt[
+						switch_ptr->switch_index[k]];
+				}
+				continue;
+			}
+			first = bit_ffs(switches_bitmap[j]);
+			if (first < 0)
+				continue;
+			last  = bit_fls(switches_bitmap[j]);
+			for (i=first; i<=last; i++) {
+				if (!bit_test(switches_bitmap[j], i))
+					continue;
+				switches_cpu_cnt[j] +=
+					_get_avail_cpus(job_ptr, i);
+			}
+		}
+	}
+	xfree(switches_set_cnt);
+}
+
 /*
  * _job_test_topo - A topology aware version of _job_test()
  * NOTE: The logic here is almost identical to that of _eval_nodes_topo() in
@@ -1144,14 +1201,7 @@ static int _job_test_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 #if SELECT_DEBUG
 	debug5("_job_test_topo: phase 2");
 #endif
-	for (i = 0; i < node_record_count; i++) {
-		avail_cpus = _get_avail_cpus(job_ptr, i);
-		for (j=0; j<switch_record_cnt; j++) {
-			if (bit_test(switches_bitmap[j], i)) {
-				switches_cpu_cnt[j] += avail_cpus;
-			}
-		}
-	}
+	_get_switches_cpu_cnt(job_ptr, switches_bitmap, switches_cpu_cnt);
 
 	/* phase 3 */
 #if SELECT_DEBUG
@@ -98,6 +98,7 @@ static void _destroy_switches(void *ptr);
 static void _free_switch_record_table(void);
 static int  _get_switch_inx(const char *name);
 static char *_get_topo_conf(void);
+static void _link_switches(void);
 static void _log_switches(void);
 static int  _node_name2bitmap(char *node_names, bitstr_t **bitmap, 
 			      hostlist_t *invalid_hostlist);
@@ -341,6 +342,7 @@ static void _validate_switches(void)
 		if (switch_ptr->node_bitmap == NULL)
 			error("switch %s has no nodes", switch_ptr->name);
 	}
+	_link_switches();
 	if (switches_bitmap) {
 		bit_not(switches_bitmap);
 		i = bit_set_count(switches_bitmap);
@@ -378,6 +380,50 @@ static void _validate_switches(void)
 	_log_switches();
 }
 
+/*
+ * Record the parent and direct descendent switches of every switch so the
+ * select plugins can walk the tree level by level instead of testing every
+ * switch's node_bitmap against every node.
+ */
+static void _link_switches(void)
+{
+	int i, j;
+	struct switch_record *switch_ptr;
+	hostlist_t hl;
+	char *child;
+
+	switch_levels = 0;
+	switch_ptr = switch_record_table;
+	for (i=0; i<switch_record_cnt; i++, switch_ptr++)
+		switch_ptr->parent = (uint16_t) NO_VAL;
+
+	switch_ptr = switch_record_table;
+	for (i=0; i<switch_record_cnt; i++, switch_ptr++) {
+		switch_levels = MAX(switch_levels, switch_ptr->level);
+		if (!switch_ptr->switches)
+			continue;
+		hl = hostlist_create(switch_ptr->switches);
+		if (!hl)
+			fatal("hostlist_create: malloc failure");
+		switch_ptr->switch_index = xmalloc(sizeof(uint16_t) *
+						   hostlist_count(hl));
+		while ((child = hostlist_shift(hl))) {
+			j = _get_switch_inx(child);
+			free(child);
+			if (j < 0)	/* already validated above */
+				continue;
+			switch_ptr->switch_index[switch_ptr->num_switches++] =
+				j;
+			if (switch_record_table[j].parent != (uint16_t) NO_VAL) {
+				error("WARNING: switch %s has multiple parent "
+				      "switches", switch_record_table[j].name);
+			}
+			switch_record_table[j].parent = i;
+		}
+		hostlist_destroy(hl);
+	}
+}
+
 static void _log_switches(void)
 {
 	int i;
@@ -420,10 +466,12 @@ static void _free_switch_record_table(void)
 			xfree(switch_record_table[i].name);
 			xfree(switch_record_table[i].nodes);
 			xfree(switch_record_table[i].switches);
+			xfree(switch_record_table[i].switch_index);
 			FREE_NULL_BITMAP(switch_record_table[i].node_bitmap);
 		}
 		xfree(switch_record_table);
 		switch_record_cnt = 0;
+		switch_levels = 0;
 	}
 }
 
@@ -546,6 +594,7 @@ static int _node_name2bitmap(char *node_names, bitstr_t **bitmap,
 	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
+	struct node_record *node_ptr = NULL;
 
 	my_bitmap = (bitstr_t *) bit_alloc(node_record_count);
 	if (my_bitmap == NULL)
@@ -565,8 +614,7 @@ static int _node_name2bitmap(char *node_names, bitstr_t **bitmap,
 	}
 
 	while ( (this_node_name = hostlist_shift(host_list)) ) {
-		struct node_record *node_ptr;
-		node_ptr = find_node_record(this_node_name);
+		node_ptr = find_node_record_after(node_ptr, this_node_name);
 		if (node_ptr) {
 			bit_set(my_bitmap, 
 				(bitoff_t) (node_ptr - node_record_table_ptr));
@@ -75,6 +75,10 @@ static pthread_mutex_t agent_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cnt_cond  = PTHREAD_COND_INITIALIZER;
 static int agent_cnt = 0;
 
+/* Preserve some data structures across calls for better performance */
+static int threads_used = 0;
+static thd_t thread_info[MAX_THREADS];
+
 static void *_agent_thread(void *args);
 
 static void *_agent_thread(void *args)
@@ -84,12 +88,17 @@ static void *_agent_thread(void *args)
 	ListIterator itr;
 	ret_data_info_t *ret_data_info = NULL;
 	int rc = 0, msg_rc;
-
-	ret_list = slurm_send_recv_msgs(thread_ptr->nodelist,
-					&thread_ptr->msg,
-					params.timeout, false);
+	hostlist_t hl;
+
+	/* Send the block only to the first node of our share and have it
+	 * relay the block down the tree to the others, so each block is
+	 * sent from here once per thread rather than TreeWidth times */
+	hl = hostlist_create(thread_ptr->nodelist);
+	ret_list = start_msg_tree_width(hl, &thread_ptr->msg,
+					params.timeout, 1);
+	hostlist_destroy(hl);
 	if (ret_list == NULL) {
-		error("slurm_send_recv_msgs: %m");
+		error("start_msg_tree_width: %m");
 		exit(1);
 	}
 
@@ -117,15 +126,13 @@ static void *_agent_thread(void *args)
 	return NULL;
 }
 
-/* Issue the RPC to transfer the file's data */
+/* Issue the RPC to transfer the file's data. Returns once the RPCs are
+ * started, call wait_rpc() before modifying bcast_msg or sending the
+ * next block */
 extern void send_rpc(file_bcast_msg_t *bcast_msg,
 		     job_sbcast_cred_msg_t *sbcast_cred)
 {
-	/* Preserve some data structures across calls for better performance */
-	static int threads_used = 0;
-	static thd_t thread_info[MAX_THREADS];
-
-	int i, fanout, rc = SLURM_SUCCESS;
+	int i, fanout;
 	int retries = 0;
 	pthread_attr_t attr;
 
@@ -198,13 +205,19 @@ extern void send_rpc(file_bcast_msg_t *bcast_msg,
 			sleep(1);	/* sleep and retry */
 		}
 	}
+	pthread_attr_destroy(&attr);
+}
+
+/* Wait for the RPCs issued by send_rpc() to complete, exit on failure */
+extern void wait_rpc(void)
+{
+	int i, rc = SLURM_SUCCESS;
 
 	/* wait until pthreads complete */
 	slurm_mutex_lock(&agent_cnt_mutex);
 	while (agent_cnt)
 		pthread_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
 	slurm_mutex_unlock(&agent_cnt_mutex);
-	pthread_attr_destroy(&attr);
 
 	for (i=0; i<threads_used; i++)
 		 rc = MAX(rc, thread_info[i].rc);
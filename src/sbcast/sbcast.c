@@ -187,52 +187,65 @@ static ssize_t _get_block(char *buffer, size_t buf_size)
 	return buf_used;
 }
 
-/* read and broadcast the file */
+/* read and broadcast the file, reading each block while the previous
+ * one is being sent (double buffering) */
 static void _bcast_file(void)
 {
-	int buf_size;
+	int buf_size, i, next;
 	ssize_t size_read = 0;
-	file_bcast_msg_t bcast_msg;
-	char *buffer;
+	file_bcast_msg_t bcast_msg[2];
+	char *buffer[2];
 
 	if (params.block_size)
 		buf_size = MIN(params.block_size, f_stat.st_size);
 	else
 		buf_size = MIN((512 * 1024), f_stat.st_size);
 
-	bcast_msg.fname		= params.dst_fname;
-	bcast_msg.block_no	= 1;
-	bcast_msg.last_block	= 0;
-	bcast_msg.force		= params.force;
-	bcast_msg.modes		= f_stat.st_mode;
-	bcast_msg.uid		= f_stat.st_uid;
-	bcast_msg.gid		= f_stat.st_gid;
-	buffer			= xmalloc(buf_size);
-	bcast_msg.block		= buffer;
-	bcast_msg.block_len	= 0;
-	bcast_msg.cred          = sbcast_cred->sbcast_cred;
+	bcast_msg[0].fname	= params.dst_fname;
+	bcast_msg[0].block_no	= 1;
+	bcast_msg[0].last_block	= 0;
+	bcast_msg[0].force	= params.force;
+	bcast_msg[0].modes	= f_stat.st_mode;
+	bcast_msg[0].uid	= f_stat.st_uid;
+	bcast_msg[0].gid	= f_stat.st_gid;
+	bcast_msg[0].block_len	= 0;
+	bcast_msg[0].cred	= sbcast_cred->sbcast_cred;
 
 	if (params.preserve) {
-		bcast_msg.atime     = f_stat.st_atime;
-		bcast_msg.mtime     = f_stat.st_mtime;
+		bcast_msg[0].atime     = f_stat.st_atime;
+		bcast_msg[0].mtime     = f_stat.st_mtime;
 	} else {
-		bcast_msg.atime     = 0;
-		bcast_msg.mtime     = 0;
+		bcast_msg[0].atime     = 0;
+		bcast_msg[0].mtime     = 0;
+	}
+	bcast_msg[1] = bcast_msg[0];
+	for (i = 0; i < 2; i++) {
+		buffer[i] = xmalloc(buf_size);
+		bcast_msg[i].block = buffer[i];
 	}
 
+	i = 0;
+	bcast_msg[i].block_len = _get_block(buffer[i], buf_size);
 	while (1) {
-		bcast_msg.block_len = _get_block(buffer, buf_size);
-		debug("block %d, size %u", bcast_msg.block_no,
-		      bcast_msg.block_len);
-		size_read += bcast_msg.block_len;
+		debug("block %d, size %u", bcast_msg[i].block_no,
+		      bcast_msg[i].block_len);
+		size_read += bcast_msg[i].block_len;
 		if (size_read >= f_stat.st_size)
-			bcast_msg.last_block = 1;
+			bcast_msg[i].last_block = 1;
 
-		send_rpc(&bcast_msg, sbcast_cred);
-		if (bcast_msg.last_block)
+		send_rpc(&bcast_msg[i], sbcast_cred);
+		if (bcast_msg[i].last_block)
 			break;	/* end of file */
-		bcast_msg.block_no++;
+
+		/* read the next block while this one is in transit */
+		next = 1 - i;
+		bcast_msg[next].block_no = bcast_msg[i].block_no + 1;
+		bcast_msg[next].block_len = _get_block(buffer[next], buf_size);
+		wait_rpc();
+		i = next;
 	}
+	wait_rpc();
 
-	xfree(buffer);
+	xfree(buffer[0]);
+	xfree(buffer[1]);
 }
@@ -60,6 +60,7 @@
 #include "src/common/forward.h"
 #include "src/common/gres.h"
 #include "src/common/hostlist.h"
+#include "src/common/list.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
@@ -90,6 +91,20 @@
 
 #include "src/plugins/select/bluegene/bg_enums.h"
 
+/* Epilog complete messages queued for processing in a batch. The first
+ * RPC thread to find the queue idle drains it, taking the job write lock
+ * once for every message that arrived while it was waiting. */
+typedef struct epilog_comp {
+	uint32_t job_id;
+	char *node_name;
+	uint32_t return_code;
+} epilog_comp_t;
+
+static pthread_mutex_t epilog_comp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List epilog_comp_list = NULL;
+static bool epilog_comp_busy = false;
+
+static void         _epilog_comp_del(void *x);
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int 	    _launch_batch_step(job_desc_msg_t *job_desc_msg,
@@ -1392,8 +1407,21 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 	}
 }
 
+static void _epilog_comp_del(void *x)
+{
+	epilog_comp_t *ec = (epilog_comp_t *) x;
+
+	if (ec) {
+		xfree(ec->node_name);
+		xfree(ec);
+	}
+}
+
 /* _slurm_rpc_epilog_complete - process RPC noting the completion of
- * the epilog denoting the completion of a job it its entirety */
+ * the epilog denoting the completion of a job it its entirety.
+ * When a large job ends every node reports at about the same time, so
+ * messages are queued and processed in batches under a single job write
+ * lock with one scheduling pass per batch. */
 static void  _slurm_rpc_epilog_complete(slurm_msg_t * msg)
 {
 	DEF_TIMERS;
@@ -1403,9 +1431,11 @@ static void  _slurm_rpc_epilog_complete(slurm_msg_t * msg)
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
 	epilog_complete_msg_t *epilog_msg =
 		(epilog_complete_msg_t *) msg->data;
+	epilog_comp_t *ec;
+	List work_list;
 	bool run_scheduler = false;
+	int batch_cnt;
 
-	START_TIMER;
 	debug2("Processing RPC: MESSAGE_EPILOG_COMPLETE uid=%d", uid);
 	if (!validate_slurm_user(uid)) {
 		error("Security violation, EPILOG_COMPLETE RPC from uid=%d",
@@ -1413,28 +1443,64 @@ static void  _slurm_rpc_epilog_complete(slurm_msg_t * msg)
 		return;
 	}
 
-	lock_slurmctld(job_write_lock);
-	if (job_epilog_complete(epilog_msg->job_id, epilog_msg->node_name,
-				epilog_msg->return_code))
-		run_scheduler = true;
-	unlock_slurmctld(job_write_lock);
-	END_TIMER2("_slurm_rpc_epilog_complete");
+	ec = xmalloc(sizeof(epilog_comp_t));
+	ec->job_id      = epilog_msg->job_id;
+	ec->node_name   = xstrdup(epilog_msg->node_name);
+	ec->return_code = epilog_msg->return_code;
+
+	slurm_mutex_lock(&epilog_comp_mutex);
+	if (!epilog_comp_list)
+		epilog_comp_list = list_create(_epilog_comp_del);
+	list_append(epilog_comp_list, ec);
+	if (epilog_comp_busy) {
+		/* Another thread is draining the queue and will
+		 * process this message along with its own */
+		slurm_mutex_unlock(&epilog_comp_mutex);
+		return;
+	}
+	epilog_comp_busy = true;
 
-	if (epilog_msg->return_code)
-		error("_slurm_rpc_epilog_complete JobId=%u Node=%s Err=%s %s",
-		      epilog_msg->job_id, epilog_msg->node_name,
-		      slurm_strerror(epilog_msg->return_code), TIME_STR);
-	else
-		debug2("_slurm_rpc_epilog_complete JobId=%u Node=%s %s",
-		       epilog_msg->job_id, epilog_msg->node_name,
-		       TIME_STR);
+	while (list_count(epilog_comp_list)) {
+		work_list = epilog_comp_list;
+		epilog_comp_list = list_create(_epilog_comp_del);
+		slurm_mutex_unlock(&epilog_comp_mutex);
 
-	/* Functions below provide their own locking */
-	if (run_scheduler) {
-		(void) schedule(0);
-		schedule_node_save();
-		schedule_job_save();
+		START_TIMER;
+		batch_cnt = list_count(work_list);
+		lock_slurmctld(job_write_lock);
+		while ((ec = list_dequeue(work_list))) {
+			if (job_epilog_complete(ec->job_id, ec->node_name,
+						ec->return_code))
+				run_scheduler = true;
+			if (ec->return_code) {
+				error("_slurm_rpc_epilog_complete JobId=%u "
+				      "Node=%s Err=%s", ec->job_id,
+				      ec->node_name,
+				      slurm_strerror(ec->return_code));
+			} else {
+				debug2("_slurm_rpc_epilog_complete JobId=%u "
+				       "Node=%s", ec->job_id, ec->node_name);
+			}
+			_epilog_comp_del(ec);
+		}
+		unlock_slurmctld(job_write_lock);
+		list_destroy(work_list);
+		END_TIMER2("_slurm_rpc_epilog_complete");
+		debug2("_slurm_rpc_epilog_complete processed %d messages %s",
+		       batch_cnt, TIME_STR);
+
+		/* Functions below provide their own locking */
+		if (run_scheduler) {
+			(void) schedule(0);
+			schedule_node_save();
+			schedule_job_save();
+			run_scheduler = false;
+		}
+
+		slurm_mutex_lock(&epilog_comp_mutex);
 	}
+	epilog_comp_busy = false;
+	slurm_mutex_unlock(&epilog_comp_mutex);
 
 	/* NOTE: RPC has no response */
 }
@@ -78,6 +78,7 @@
 
 static void _build_pending_step(struct job_record  *job_ptr,
 				job_step_create_request_msg_t *step_specs);
+static uint32_t *_build_usable_cpu_cnt(struct job_record *job_ptr);
 static int  _count_cpus(struct job_record *job_ptr, bitstr_t *bitmap,
 			uint32_t *usable_cpu_cnt);
 static struct step_record * _create_step_record(struct job_record *job_ptr);
@@ -99,6 +100,8 @@ static bitstr_t * _pick_step_nodes(struct job_record *job_ptr,
 static bitstr_t *_pick_step_nodes_cpus(struct job_record *job_ptr,
 				       bitstr_t *nodes_bitmap, int node_cnt,
 				       int cpu_cnt, uint32_t *usable_cpu_cnt);
+static bitstr_t *_step_idle_nodes(struct job_record *job_ptr,
+				  bitstr_t *nodes_avail);
 static hostlist_t _step_range_to_hostlist(struct step_record *step_ptr,
 				uint32_t range_first, uint32_t range_last);
 static int _step_hostname_to_inx(struct step_record *step_ptr,
@@ -744,8 +747,6 @@ _pick_step_nodes (struct job_record  *job_ptr,
 	int error_code, nodes_picked_cnt = 0, cpus_picked_cnt = 0;
 	int cpu_cnt, i, task_cnt;
 	int mem_blocked_nodes = 0, mem_blocked_cpus = 0;
-	ListIterator step_iterator;
-	struct step_record *step_p;
 	job_resources_t *job_resrcs_ptr = job_ptr->job_resrcs;
 	uint32_t *usable_cpu_cnt = NULL;
 
@@ -1178,28 +1179,9 @@ _pick_step_nodes (struct job_record  *job_ptr,
 		bit_not (relative_nodes);
 		bit_and (nodes_avail, relative_nodes);
 		FREE_NULL_BITMAP (relative_nodes);
-	} else {
-		nodes_idle = bit_alloc (bit_size (nodes_avail) );
-		if (nodes_idle == NULL)
-			fatal("bit_alloc malloc failure");
-		step_iterator = list_iterator_create(job_ptr->step_list);
-		while ((step_p = (struct step_record *)
-			list_next(step_iterator))) {
-			if (step_p->state != JOB_RUNNING)
-				continue;
-			bit_or(nodes_idle, step_p->step_node_bitmap);
-			if (slurm_get_debug_flags() & DEBUG_FLAG_STEPS) {
-				char *temp;
-				temp = bitmap2node_name(step_p->
-							step_node_bitmap);
-				info("step %u.%u has nodes %s",
-				     job_ptr->job_id, step_p->step_id, temp);
-				xfree(temp);
-			}
-		}
-		list_iterator_destroy (step_iterator);
-		bit_not(nodes_idle);
-		bit_and(nodes_idle, nodes_avail);
+	} else if (slurm_get_debug_flags() & DEBUG_FLAG_STEPS) {
+		/* Otherwise only built if the min_nodes logic needs it */
+		nodes_idle = _step_idle_nodes(job_ptr, nodes_avail);
 	}
 
 	if (slurm_get_debug_flags() & DEBUG_FLAG_STEPS) {
@@ -1240,30 +1222,21 @@ _pick_step_nodes (struct job_record  *job_ptr,
 	if (step_spec->min_nodes) {
 		int cpus_needed, node_avail_cnt, nodes_needed;
 
-		if (usable_cpu_cnt == NULL) {
-			usable_cpu_cnt = xmalloc(sizeof(uint32_t) *
-						 node_record_count);
-			first_bit = bit_ffs(job_resrcs_ptr->node_bitmap);
-			last_bit  = bit_fls(job_resrcs_ptr->node_bitmap);
-			for (i=first_bit, node_inx=-1; i<=last_bit; i++) {
-				if (!bit_test(job_resrcs_ptr->node_bitmap, i))
-					continue;
-				node_inx++;
-				usable_cpu_cnt[i] = job_resrcs_ptr->
-						    cpus[node_inx];
-			}
-
-		}
+		if (usable_cpu_cnt == NULL)
+			usable_cpu_cnt = _build_usable_cpu_cnt(job_ptr);
 		nodes_picked_cnt = bit_set_count(nodes_picked);
 		if (slurm_get_debug_flags() & DEBUG_FLAG_STEPS) {
 			verbose("step picked %d of %u nodes",
 				nodes_picked_cnt, step_spec->min_nodes);
 		}
+		nodes_needed = step_spec->min_nodes - nodes_picked_cnt;
+		if ((nodes_needed > 0) && !nodes_idle &&
+		    (step_spec->relative == (uint16_t)NO_VAL))
+			nodes_idle = _step_idle_nodes(job_ptr, nodes_avail);
 		if (nodes_idle)
 			node_avail_cnt = bit_set_count(nodes_idle);
 		else
 			node_avail_cnt = 0;
-		nodes_needed = step_spec->min_nodes - nodes_picked_cnt;
 		if ((nodes_needed > 0) &&
 		    (node_avail_cnt >= nodes_needed)) {
 			cpus_needed = _opt_cpu_cnt(step_spec->cpu_count,
@@ -1336,34 +1309,37 @@ _pick_step_nodes (struct job_record  *job_ptr,
 		}
 	} else if (step_spec->cpu_count) {
 		/* make sure the selected nodes have enough cpus */
+		if (usable_cpu_cnt == NULL)
+			usable_cpu_cnt = _build_usable_cpu_cnt(job_ptr);
 		cpus_picked_cnt = _count_cpus(job_ptr, nodes_picked,
 					      usable_cpu_cnt);
 		if ((step_spec->cpu_count > cpus_picked_cnt) &&
 		    ((step_spec->max_nodes == 0) ||
 		     (step_spec->max_nodes > nodes_picked_cnt))) {
-			/* Attempt to add more nodes to allocation */
+			/* Attempt to add more nodes to allocation, taking
+			 * them in order and reading each CPU count directly */
 			nodes_picked_cnt = bit_set_count(nodes_picked);
-			while (step_spec->cpu_count > cpus_picked_cnt) {
-				node_tmp = bit_pick_cnt(nodes_avail, 1);
-				if (node_tmp == NULL)
-					break;
+			first_bit = bit_ffs(nodes_avail);
+			if (first_bit >= 0)
+				last_bit = bit_fls(nodes_avail);
+			else
+				last_bit = first_bit - 1;
+			for (i = first_bit; ((i <= last_bit) &&
+			     (step_spec->cpu_count > cpus_picked_cnt)); i++) {
+				if (!bit_test(nodes_avail, i))
+					continue;
+				bit_clear(nodes_avail, i);
+				if (!bit_test(job_ptr->node_bitmap, i))
+					continue;
 
-				cpu_cnt = _count_cpus(job_ptr, node_tmp,
-						      usable_cpu_cnt);
+				cpu_cnt = usable_cpu_cnt[i];
 				if (cpu_cnt == 0) {
 					/* Node not usable (memory insufficient
 					 * to allocate any CPUs, etc.) */
-					bit_not(node_tmp);
-					bit_and(nodes_avail, node_tmp);
-					FREE_NULL_BITMAP(node_tmp);
 					continue;
 				}
 
-				bit_or  (nodes_picked, node_tmp);
-				bit_not (node_tmp);
-				bit_and (nodes_avail, node_tmp);
-				FREE_NULL_BITMAP (node_tmp);
-				node_tmp = NULL;
+				bit_set(nodes_picked, i);
 				nodes_picked_cnt += 1;
 				if (step_spec->min_nodes)
 					step_spec->min_nodes = nodes_picked_cnt;
@@ -1410,6 +1386,86 @@ cleanup:
 	return NULL;
 }
 
+/*
+ * _step_idle_nodes - identify the job's available nodes which are not used
+ *	by any of its running steps
+ * IN job_ptr - point to job
+ * IN nodes_avail - map of the job's nodes available to the step
+ * RET bitmap of idle nodes, free using FREE_NULL_BITMAP()
+ */
+static bitstr_t *_step_idle_nodes(struct job_record *job_ptr,
+				  bitstr_t *nodes_avail)
+{
+	bitstr_t *nodes_idle;
+	ListIterator step_iterator;
+	struct step_record *step_p;
+
+	nodes_idle = bit_alloc(bit_size(nodes_avail));
+	if (nodes_idle == NULL)
+		fatal("bit_alloc malloc failure");
+	step_iterator = list_iterator_create(job_ptr->step_list);
+	while ((step_p = (struct step_record *) list_next(step_iterator))) {
+		if (step_p->state != JOB_RUNNING)
+			continue;
+		bit_or(nodes_idle, step_p->step_node_bitmap);
+		if (slurm_get_debug_flags() & DEBUG_FLAG_STEPS) {
+			char *temp;
+			temp = bitmap2node_name(step_p->step_node_bitmap);
+			info("step %u.%u has nodes %s",
+			     job_ptr->job_id, step_p->step_id, temp);
+			xfree(temp);
+		}
+	}
+	list_iterator_destroy(step_iterator);
+	bit_not(nodes_idle);
+	bit_and(nodes_idle, nodes_avail);
+
+	return nodes_idle;
+}
+
+/*
+ * _build_usable_cpu_cnt - build a table of the CPUs allocated to this job,
+ *	indexed by global node index, for use when memory and gres do not
+ *	further limit the usable CPU count
+ * IN job_ptr - point to job
+ * RET table of node_record_count elements, free using xfree()
+ */
+static uint32_t *_build_usable_cpu_cnt(struct job_record *job_ptr)
+{
+	job_resources_t *job_resrcs_ptr = job_ptr->job_resrcs;
+	struct node_record *node_ptr;
+	uint32_t *usable_cpu_cnt;
+	int i, first_bit, last_bit, node_inx;
+
+	usable_cpu_cnt = xmalloc(sizeof(uint32_t) * node_record_count);
+	if (!job_resrcs_ptr || !job_resrcs_ptr->cpus ||
+	    !job_resrcs_ptr->node_bitmap) {
+		error("job %u lacks cpus array", job_ptr->job_id);
+		for (i = 0, node_ptr = node_record_table_ptr;
+		     i < node_record_count; i++, node_ptr++) {
+			if (slurmctld_conf.fast_schedule)
+				usable_cpu_cnt[i] = node_ptr->config_ptr->cpus;
+			else
+				usable_cpu_cnt[i] = node_ptr->cpus;
+		}
+		return usable_cpu_cnt;
+	}
+
+	first_bit = bit_ffs(job_resrcs_ptr->node_bitmap);
+	if (first_bit >= 0)
+		last_bit  = bit_fls(job_resrcs_ptr->node_bitmap);
+	else
+		last_bit = first_bit - 1;
+	for (i = first_bit, node_inx = -1; i <= last_bit; i++) {
+		if (!bit_test(job_resrcs_ptr->node_bitmap, i))
+			continue;
+		node_inx++;
+		usable_cpu_cnt[i] = job_resrcs_ptr->cpus[node_inx];
+	}
+
+	return usable_cpu_cnt;
+}
+
 /*
  * _count_cpus - report how many cpus are allocated to this job for the
  *		 identified nodes
@@ -1422,11 +1478,26 @@ cleanup:
 static int _count_cpus(struct job_record *job_ptr, bitstr_t *bitmap,
 		       uint32_t *usable_cpu_cnt)
 {
-	int i, sum = 0;
+	int i, first_bit, last_bit, sum = 0;
 	struct node_record *node_ptr;
 
-	if (job_ptr->job_resrcs && job_ptr->job_resrcs->cpus &&
-	    job_ptr->job_resrcs->node_bitmap) {
+	if (usable_cpu_cnt) {
+		/* Only visit the nodes being tallied */
+		first_bit = bit_ffs(bitmap);
+		if (first_bit >= 0)
+			last_bit  = bit_fls(bitmap);
+		else
+			last_bit = first_bit - 1;
+		for (i = first_bit; i <= last_bit; i++) {
+			if (!bit_test(bitmap, i) ||
+			    !bit_test(job_ptr->node_bitmap, i)) {
+				/* absent from current job or step bitmap */
+				continue;
+			}
+			sum += usable_cpu_cnt[i];
+		}
+	} else if (job_ptr->job_resrcs && job_ptr->job_resrcs->cpus &&
+		   job_ptr->job_resrcs->node_bitmap) {
 		int node_inx = -1;
 		for (i = 0, node_ptr = node_record_table_ptr;
 		     i < node_record_count; i++, node_ptr++) {
@@ -1438,10 +1509,7 @@ static int _count_cpus(struct job_record *job_ptr, bitstr_t *bitmap,
 				/* absent from current job or step bitmap */
 				continue;
 			}
-			if (usable_cpu_cnt)
-				sum += usable_cpu_cnt[i];
-			else
-				sum += job_ptr->job_resrcs->cpus[node_inx];
+			sum += job_ptr->job_resrcs->cpus[node_inx];
 		}
 	} else {
 		error("job %u lacks cpus array", job_ptr->job_id);
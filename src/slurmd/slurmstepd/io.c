@@ -68,6 +68,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -442,14 +443,18 @@ _client_read(eio_obj_t *obj, List objs)
 }
 
 /*
- * Write outgoing packed messages to the client socket.
+ * Write outgoing packed messages to the client socket.  Up to
+ * STDIO_MAX_WRITEV queued messages are gathered into a single writev()
+ * straight from their buffers, so heavy task output costs one system
+ * call per batch rather than one per message.
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct io_buf *msgs[STDIO_MAX_WRITEV];
+	struct iovec iov[STDIO_MAX_WRITEV];
+	int i, cnt, n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -473,34 +478,57 @@ _client_write(eio_obj_t *obj, List objs)
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
 	/*
-	 * Write message to socket.
+	 * Gather the partially sent message and whatever follows it
+	 * in the queue.
 	 */
-	buf = client->out_msg->data +
+	msgs[0] = client->out_msg;
+	iov[0].iov_base = client->out_msg->data +
 		(client->out_msg->length - client->out_remaining);
+	iov[0].iov_len  = client->out_remaining;
+	for (cnt = 1; cnt < STDIO_MAX_WRITEV; cnt++) {
+		if (!(msgs[cnt] = list_dequeue(client->msg_queue)))
+			break;
+		iov[cnt].iov_base = msgs[cnt]->data;
+		iov[cnt].iov_len  = msgs[cnt]->length;
+	}
+
+	/*
+	 * Write messages to socket.
+	 */
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, cnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
 			debug5("_client_write returned EAGAIN");
-			return SLURM_SUCCESS;
+			n = 0;
 		} else {
+			for (i = cnt - 1; i > 0; i--)
+				list_push(client->msg_queue, msgs[i]);
 			client->out_eof = true;
 			_free_all_outgoing_msgs(client->msg_queue, client->job);
 			return SLURM_SUCCESS;
 		}
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket", 
-		      n, client->out_remaining);
-	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
+	debug5("Wrote %d bytes to socket", n);
 
-	_free_outgoing_msg(client->out_msg, client->job);
+	/* Release every message sent in full */
+	for (i = 0; i < cnt; i++) {
+		if ((size_t) n < iov[i].iov_len)
+			break;
+		n -= iov[i].iov_len;
+		_free_outgoing_msg(msgs[i], client->job);
+	}
 	client->out_msg = NULL;
+	if (i == cnt)
+		return SLURM_SUCCESS;
+
+	/* Resume from the first message not sent in full, and return
+	 * the others to the head of the queue in their original order */
+	client->out_msg = msgs[i];
+	client->out_remaining = iov[i].iov_len - n;
+	for (cnt--; cnt > i; cnt--)
+		list_push(client->msg_queue, msgs[cnt]);
 
 	return SLURM_SUCCESS;
 }
@@ -728,7 +756,7 @@ _create_task_out_eio(int fd, uint16_t type,
 	out->gtaskid = task->gtid;
 	out->ltaskid = task->id;
 	out->job = job;
-	out->buf = cbuf_create(MAX_MSG_LEN, MAX_MSG_LEN*4);
+	out->buf = cbuf_create(MAX_MSG_LEN, STDIO_MAX_TASK_BUF);
 	out->eof = false;
 	out->eof_msg_sent = false;
 	if (cbuf_opt_set(out->buf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) == -1)
@@ -51,6 +51,16 @@
 #define STDIO_MAX_FREE_BUF 1024
 #define STDIO_MAX_MSG_CACHE 128
 
+/*
+ * Upper bound on the cbuf holding each task's unsent stdout or stderr.
+ * The cbuf starts at MAX_MSG_LEN and grows on demand, letting a task
+ * emitting bursts of output keep running while messages are in flight.
+ */
+#define STDIO_MAX_TASK_BUF (MAX_MSG_LEN * 64)
+
+/* Most queued messages gathered into a single writev() to a client */
+#define STDIO_MAX_WRITEV 16
+
 struct io_buf {
 	int ref_count;
 	uint32_t length;
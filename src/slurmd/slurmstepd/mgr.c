@@ -97,6 +97,7 @@
 #include "src/common/safeopen.h"
 #include "src/common/slurm_jobacct_gather.h"
 #include "src/common/switch.h"
+#include "src/common/timers.h"
 #include "src/common/util-net.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xsignal.h"
@@ -1309,6 +1310,9 @@ _fork_all_tasks(slurmd_job_t *job, bool *io_initialized)
 	jobacct_id_t jobacct_id;
 	char *oom_value;
 	List exec_wait_list = NULL;
+	ListIterator exec_wait_iter;
+	struct exec_wait_info *ei;
+	DEF_TIMERS;
 
 	xassert(job != NULL);
 
@@ -1393,10 +1397,10 @@ _fork_all_tasks(slurmd_job_t *job, bool *io_initialized)
 	/*
 	 * Fork all of the task processes.
 	 */
+	START_TIMER;
 	for (i = 0; i < job->node_tasks; i++) {
 		char time_stamp[256];
 		pid_t pid;
-		struct exec_wait_info *ei;
 
 		if ((ei = fork_child_with_wait_info (i)) == NULL) {
 			error("child fork: %m");
@@ -1497,6 +1501,13 @@ _fork_all_tasks(slurmd_job_t *job, bool *io_initialized)
 		error ("Unable to return to working directory");
 	}
 
+	/*
+	 * Each task is unblocked, so it may call exec, as soon as it has
+	 * been placed in the process group and container and the post-fork
+	 * hooks have run for it, rather than holding every task until the
+	 * whole node is set up. Tasks are still released in order.
+	 */
+	exec_wait_iter = list_iterator_create(exec_wait_list);
 	for (i = 0; i < job->node_tasks; i++) {
 		/*
 		 * Put this task in the step process group
@@ -1517,7 +1528,7 @@ _fork_all_tasks(slurmd_job_t *job, bool *io_initialized)
 		    == SLURM_ERROR) {
 			error("slurm_container_add: %m");
 			rc = SLURM_ERROR;
-			goto fail2;
+			goto fail5;
 		}
 		jobacct_id.nodeid = job->nodeid;
 		jobacct_id.taskid = job->task[i]->gtid;
@@ -1535,16 +1546,18 @@ _fork_all_tasks(slurmd_job_t *job, bool *io_initialized)
 		if (spank_task_post_fork (job, i) < 0) {
 			error ("spank task %d post-fork failed", i);
 			rc = SLURM_ERROR;
-			goto fail2;
+			goto fail5;
 		}
+
+		if ((ei = list_next(exec_wait_iter)))
+			exec_wait_signal(ei, job);
 	}
 //	jobacct_gather_set_proctrack_container_id(job->cont_id);
-
-	/*
-	 * Now it's ok to unblock the tasks, so they may call exec.
-	 */
-	list_for_each (exec_wait_list, (ListForF) exec_wait_signal, job);
+	list_iterator_destroy(exec_wait_iter);
 	list_destroy (exec_wait_list);
+	END_TIMER;
+	debug("%u.%u: started %d tasks %s",
+	      job->jobid, job->stepid, job->node_tasks, TIME_STR);
 
 	for (i = 0; i < job->node_tasks; i++) {
 		/*
@@ -1558,6 +1571,11 @@ _fork_all_tasks(slurmd_job_t *job, bool *io_initialized)
 
 	return rc;
 
+fail5:
+	/* tasks not yet unblocked see EOF and exit */
+	list_iterator_destroy(exec_wait_iter);
+	list_destroy (exec_wait_list);
+	goto fail2;
 fail4:
 	if (chdir (sprivs.saved_cwd) < 0) {
 		error ("Unable to return to working directory");
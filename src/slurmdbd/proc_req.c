@@ -3390,6 +3390,45 @@ static int   _send_mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
 	return SLURM_SUCCESS;
 }
 
+/* Return the return code packed in the reply to one record of a
+ * DBD_SEND_MULT_MSG, the same one the client checks before it
+ * considers the record stored. */
+static int _mult_msg_ret_rc(uint16_t rpc_version, Buf ret_buf)
+{
+	uint16_t msg_type;
+	uint32_t offset = get_buf_offset(ret_buf);
+	dbd_rc_msg_t *msg = NULL;
+	dbd_id_rc_msg_t *id_msg = NULL;
+	int rc = SLURM_SUCCESS;
+
+	set_buf_offset(ret_buf, 0);
+	safe_unpack16(&msg_type, ret_buf);
+	switch (msg_type) {
+	case DBD_ID_RC:
+		if (slurmdbd_unpack_id_rc_msg((void **)&id_msg, rpc_version,
+					      ret_buf) != SLURM_SUCCESS)
+			goto unpack_error;
+		rc = id_msg->return_code;
+		slurmdbd_free_id_rc_msg(id_msg);
+		break;
+	case DBD_RC:
+		if (slurmdbd_unpack_rc_msg(&msg, rpc_version, ret_buf)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+		rc = msg->return_code;
+		slurmdbd_free_rc_msg(msg);
+		break;
+	default:
+		break;
+	}
+	set_buf_offset(ret_buf, offset);
+	return rc;
+
+unpack_error:
+	set_buf_offset(ret_buf, offset);
+	return SLURM_ERROR;
+}
+
 static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 			    Buf in_buffer, Buf *out_buffer,
 			    uint32_t *uid)
@@ -3399,7 +3438,7 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 	char *comment = NULL;
 	ListIterator itr = NULL;
 	Buf req_buf = NULL, ret_buf = NULL;
-	int rc = SLURM_SUCCESS;
+	int rc = SLURM_SUCCESS, batch_rc;
 
 	if (*uid != slurmdbd_conf->slurm_user_id) {
 		comment = "DBD_SEND_MULT_MSG message from invalid uid";
@@ -3423,18 +3462,68 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
 
+	/* A client keeping several batches in flight numbers them in
+	 * return_code, and the number is echoed in the reply.  Once a
+	 * batch was not stored completely, later batches already on
+	 * their way are refused until the client sends the rest of that
+	 * one again, so nothing is stored ahead of it. */
+	list_msg.return_code = get_msg->return_code;
+	if (list_msg.return_code && slurmdbd_conn->mult_msg_seq
+	    && (list_msg.return_code != slurmdbd_conn->mult_msg_seq)) {
+		debug("CONN:%u DBD_SEND_MULT_MSG batch %u refused, "
+		      "waiting for batch %u", slurmdbd_conn->newsockfd,
+		      list_msg.return_code, slurmdbd_conn->mult_msg_seq);
+		goto end_it;
+	}
+
+	/* Store the records in one transaction instead of committing
+	 * each of them on its own.  Processing stops at the first record
+	 * that fails, as the client only acknowledges records up to
+	 * there.  The records before it are committed and acknowledged,
+	 * unless the transaction itself was lost (a reconnect or a
+	 * deadlock throws away everything written so far).  Then
+	 * nothing is acknowledged and the client sends the whole batch
+	 * again. */
+	batch_rc = acct_storage_g_batch(slurmdbd_conn->db_conn, 1);
+
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
 		ret_buf = NULL;
 		rc = proc_req(slurmdbd_conn, get_buf_data(req_buf),
 			      size_buf(req_buf), 0, &ret_buf, uid);
-		if (ret_buf)
+		if (ret_buf) {
 			list_append(list_msg.my_list, ret_buf);
+			if (rc == SLURM_SUCCESS)
+				rc = _mult_msg_ret_rc(
+					slurmdbd_conn->rpc_version, ret_buf);
+		}
 		if (rc != SLURM_SUCCESS)
 			break;
 	}
 	list_iterator_destroy(itr);
 
+	if ((batch_rc == SLURM_SUCCESS)
+	    && (acct_storage_g_batch(slurmdbd_conn->db_conn, 0)
+		!= SLURM_SUCCESS)) {
+		error("CONN:%u DBD_SEND_MULT_MSG batch of %d not stored",
+		      slurmdbd_conn->newsockfd, list_count(get_msg->my_list));
+		list_flush(list_msg.my_list);
+	}
+
+	if (list_msg.return_code) {
+		if ((rc == SLURM_SUCCESS)
+		    && (list_count(list_msg.my_list)
+			== list_count(get_msg->my_list))) {
+			/* batch numbers skip 0 when they wrap */
+			slurmdbd_conn->mult_msg_seq =
+				list_msg.return_code + 1;
+			if (!slurmdbd_conn->mult_msg_seq)
+				slurmdbd_conn->mult_msg_seq = 1;
+		} else
+			slurmdbd_conn->mult_msg_seq = list_msg.return_code;
+	}
+
+end_it:
 	slurmdbd_free_list_msg(get_msg);
 
 	*out_buffer = init_buf(1024);
@@ -52,6 +52,8 @@ typedef struct {
 	slurm_fd_t newsockfd; /* socket connection descriptor */
 	uint16_t orig_port;
 	uint16_t rpc_version; /* version of rpc */
+	uint32_t mult_msg_seq; /* next DBD_SEND_MULT_MSG batch expected,
+				* 0 until the client numbers them */
 } slurmdbd_conn_t;
 
 /* Process an incoming RPC
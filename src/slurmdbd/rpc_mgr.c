@@ -61,6 +61,13 @@
 
 #define MAX_THREAD_COUNT 100
 
+/*
+ *  Maximum number of report queries (sacct, sreport, ...) processed at
+ *  once.  The rest wait their turn so reporting load can't take the
+ *  database away from slurmctld sending in job records.
+ */
+#define MAX_QUERY_COUNT  10
+
 /*
  *  Maximum message size. Messages larger than this value (in bytes)
  *  will not be received.
@@ -69,11 +76,14 @@
 
 /* Local functions */
 static bool   _fd_readable(slurm_fd_t fd);
+static void   _free_query_slot(void);
 static void   _free_server_thread(pthread_t my_tid);
+static bool   _is_query_msg(char *msg);
 static int    _send_resp(slurm_fd_t fd, Buf buffer);
 static void * _service_connection(void *arg);
 static void   _sig_handler(int signal);
 static int    _tot_wait (struct timeval *start_time);
+static bool   _wait_for_query_slot(void);
 static int    _wait_for_server_thread(void);
 static void   _wait_for_thread_fini(void);
 
@@ -82,6 +92,9 @@ static pthread_t       master_thread_id = 0, slave_thread_id[MAX_THREAD_COUNT];
 static int             thread_count = 0;
 static pthread_mutex_t thread_count_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  thread_count_cond = PTHREAD_COND_INITIALIZER;
+static int             query_count = 0;
+static pthread_mutex_t query_count_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  query_count_cond = PTHREAD_COND_INITIALIZER;
 
 
 /* Process incoming RPCs. Meant to execute as a pthread */
@@ -187,7 +200,7 @@ static void * _service_connection(void *arg)
 	uint32_t nw_size = 0, msg_size = 0, uid = NO_VAL;
 	char *msg = NULL;
 	ssize_t msg_read = 0, offset = 0;
-	bool fini = false, first = true;
+	bool fini = false, first = true, query;
 	Buf buffer = NULL;
 	int rc = SLURM_SUCCESS;
 
@@ -226,9 +239,17 @@ static void * _service_connection(void *arg)
 			}
 			offset += msg_read;
 		}
-		if (msg_size == offset) {
+		if ((msg_size == offset)
+		    && (query = _is_query_msg(msg))
+		    && !_wait_for_query_slot()) {
+			buffer = make_dbd_rc_msg(conn->rpc_version,
+						 SLURM_ERROR, "Shutting down", 0);
+			fini = true;
+		} else if (msg_size == offset) {
 			rc = proc_req(
 				conn, msg, msg_size, first, &buffer, &uid);
+			if (query)
+				_free_query_slot();
 			first = false;
 			if (rc != SLURM_SUCCESS && rc != ACCOUNTING_FIRST_REG) {
 				error("Processing last message from "
@@ -510,6 +531,63 @@ static void _free_server_thread(pthread_t my_tid)
 	slurm_mutex_unlock(&thread_count_lock);
 }
 
+/* Return true if msg is a report query that runs in the query slots */
+static bool _is_query_msg(char *msg)
+{
+	uint16_t msg_type;
+
+	memcpy(&msg_type, msg, sizeof(msg_type));
+	switch (ntohs(msg_type)) {
+	case DBD_GET_ASSOC_USAGE:
+	case DBD_GET_CLUSTER_USAGE:
+	case DBD_GET_EVENTS:
+	case DBD_GET_JOBS_COND:
+	case DBD_GET_RESVS:
+	case DBD_GET_TXN:
+	case DBD_GET_WCKEY_USAGE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Don't return until fewer than MAX_QUERY_COUNT queries are running,
+ * RET false if shutting down instead */
+static bool _wait_for_query_slot(void)
+{
+	struct timespec ts = {0, 0};
+	bool print_it = true;
+
+	slurm_mutex_lock(&query_count_lock);
+	while (!shutdown_time && (query_count >= MAX_QUERY_COUNT)) {
+		if (print_it) {
+			debug("query_count over limit (%d), waiting",
+			      query_count);
+			print_it = false;
+		}
+		/* wake up now and then to check for shutdown */
+		ts.tv_sec = time(NULL) + 1;
+		pthread_cond_timedwait(&query_count_cond, &query_count_lock,
+				       &ts);
+	}
+	if (!shutdown_time)
+		query_count++;
+	slurm_mutex_unlock(&query_count_lock);
+
+	return !shutdown_time;
+}
+
+static void _free_query_slot(void)
+{
+	slurm_mutex_lock(&query_count_lock);
+	if (query_count > 0)
+		query_count--;
+	else
+		error("query_count underflow");
+	pthread_cond_signal(&query_count_cond);
+	slurm_mutex_unlock(&query_count_lock);
+}
+
 /* Wait for all RPC handler threads to exit.
  * After one second, start sending SIGKILL to the threads. */
 static void _wait_for_thread_fini(void)
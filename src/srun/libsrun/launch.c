@@ -92,6 +92,49 @@ _is_local_file (fname_t *fname)
 	return ((fname->type != IO_PER_TASK) && (fname->type != IO_ONE));
 }
 
+/*
+ * Return true if the file is opened by slurmstepd on the nodes, but not
+ * as a --direct-output file
+ */
+static bool
+_is_node_file(fname_t *fname)
+{
+	return (!_is_local_file(fname) && !fname->direct);
+}
+
+static void
+_truncate_direct_file(fname_t *fname, int file_flags)
+{
+	char *path = NULL;
+	int fd;
+
+	if (!fname->direct)
+		return;
+	/* The nodes open the file relative to the --chdir directory */
+	if ((fname->name[0] != '/') && opt.cwd)
+		path = xstrdup_printf("%s/%s", opt.cwd, fname->name);
+	else
+		path = xstrdup(fname->name);
+	if ((fd = open(path, file_flags, 0644)) == -1) {
+		error("Could not open output file %s: %m", path);
+		exit(error_exit);
+	}
+	close(fd);
+	xfree(path);
+}
+
+/*
+ * Go back to writing a --direct-output file from srun
+ */
+static void
+_unset_direct_file(fname_t *fname)
+{
+	if (!fname->direct)
+		return;
+	fname->type = IO_ALL;
+	fname->direct = false;
+}
+
 /*
  * Initialize context for plugin
  */
@@ -376,6 +419,32 @@ extern void launch_common_set_stdio_fds(srun_job_t *job,
 		slurm_conf_unlock();
 	}
 
+	/*
+	 * Files written directly by slurmstepd on every node are truncated
+	 * here once, then opened in append mode by each node so they do not
+	 * discard one another's output. The open mode applies to every file
+	 * the nodes open, so if the other stream is a per-task file that is
+	 * to be truncated, the direct file is written by srun instead.
+	 */
+	if (job->ofname->direct || job->efname->direct) {
+		if ((file_flags & O_TRUNC) &&
+		    (_is_node_file(job->ofname) ||
+		     _is_node_file(job->efname))) {
+			verbose("--direct-output is not used with a "
+				"per-task --output or --error file");
+			_unset_direct_file(job->ofname);
+			_unset_direct_file(job->efname);
+		} else {
+			if (file_flags & O_TRUNC) {
+				_truncate_direct_file(job->ofname,
+						      file_flags);
+				_truncate_direct_file(job->efname,
+						      file_flags);
+			}
+			opt.open_mode = OPEN_MODE_APPEND;
+		}
+	}
+
 	/*
 	 * create stdin file descriptor
 	 */
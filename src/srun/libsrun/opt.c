@@ -188,6 +188,7 @@
 #define LONG_OPT_LAUNCHER_OPTS   0x154
 #define LONG_OPT_CPU_FREQ        0x155
 #define LONG_OPT_LAUNCH_CMD      0x156
+#define LONG_OPT_DIRECT_OUTPUT   0x157
 
 extern char **environ;
 
@@ -465,6 +466,7 @@ static void _opt_default()
 
 	opt.pty = false;
 	opt.open_mode = 0;
+	opt.direct_output = 0;
 	opt.acctg_freq = -1;
 	opt.cpu_freq = NO_VAL;
 	opt.reservation = NULL;
@@ -506,6 +508,7 @@ env_vars_t env_vars[] = {
 {"SLURM_CPU_BIND",      OPT_CPU_BIND,   NULL,               NULL             },
 {"SLURM_CPU_FREQ_REQ",  OPT_CPU_FREQ,   NULL,               NULL             },
 {"SLURM_DEPENDENCY",    OPT_STRING,     &opt.dependency,    NULL             },
+{"SLURM_DIRECT_OUTPUT", OPT_INT,        &opt.direct_output, NULL             },
 {"SLURM_DISABLE_STATUS",OPT_INT,        &opt.disable_status,NULL             },
 {"SLURM_DISTRIBUTION",  OPT_DISTRIB,    NULL,               NULL             },
 {"SLURM_EPILOG",        OPT_STRING,     &opt.epilog,        NULL             },
@@ -809,6 +812,7 @@ static void set_options(const int argc, char **argv)
 		{"cpu_bind",         required_argument, 0, LONG_OPT_CPU_BIND},
 		{"cpu-freq",         required_argument, 0, LONG_OPT_CPU_FREQ},
 		{"debugger-test",    no_argument,       0, LONG_OPT_DEBUG_TS},
+		{"direct-output",    no_argument,       0, LONG_OPT_DIRECT_OUTPUT},
 		{"epilog",           required_argument, 0, LONG_OPT_EPILOG},
 		{"exclusive",        no_argument,       0, LONG_OPT_EXCLUSIVE},
 		{"get-user-env",     optional_argument, 0, LONG_OPT_GET_USER_ENV},
@@ -1457,6 +1461,9 @@ static void set_options(const int argc, char **argv)
 				      optarg);
 			}
 			break;
+		case LONG_OPT_DIRECT_OUTPUT:
+			opt.direct_output = 1;
+			break;
 		case LONG_OPT_ACCTG_FREQ:
 			opt.acctg_freq = _get_int(optarg, "acctg-freq",
                                 false);
@@ -2360,6 +2367,7 @@ static void _opt_list(void)
 		info("immediate      : %d secs", (opt.immediate - 1));
 	info("label output   : %s", tf_(opt.labelio));
 	info("unbuffered IO  : %s", tf_(opt.unbuffered));
+	info("direct output  : %s", tf_(opt.direct_output));
 	info("overcommit     : %s", tf_(opt.overcommit));
 	info("threads        : %d", opt.max_threads);
 	if (opt.time_limit == INFINITE)
@@ -2521,6 +2529,7 @@ static void _help(void)
 "      --comment=name          arbitrary comment\n"
 "  -d, --dependency=type:jobid defer job until condition on jobid is satisfied\n"
 "  -D, --chdir=path            change remote current working directory\n"
+"      --direct-output         nodes write --output/--error files directly\n"
 "  -e, --error=err             location of stderr redirection\n"
 "      --epilog=program        run \"program\" after launching job step\n"
 "  -E, --preserve-env          env vars for node and task counts override\n"
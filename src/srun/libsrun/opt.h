@@ -219,6 +219,7 @@ typedef struct srun_options {
 	uint16_t mail_type;	/* --mail-type			*/
 	char *mail_user;	/* --mail-user			*/
 	uint8_t open_mode;	/* --open-mode=append|truncate	*/
+	int direct_output;	/* --direct-output		*/
 	int acctg_freq;		/* --acctg-freq=secs		*/
 	uint32_t cpu_freq;     	/* --cpu_freq=kilohertz		*/
 	bool pty;		/* --pty			*/
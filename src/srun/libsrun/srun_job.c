@@ -118,6 +118,7 @@ static void _print_job_information(resource_allocation_response_msg_t *resp);
 static void _run_srun_epilog (srun_job_t *job);
 static void _run_srun_prolog (srun_job_t *job);
 static int _run_srun_script (srun_job_t *job, char *script);
+static void _set_direct_output(fname_t *fname);
 static void _set_env_vars(resource_allocation_response_msg_t *resp);
 static void  _set_prio_process_env(void);
 static int _set_rlimit_env(void);
@@ -860,6 +861,25 @@ job_update_io_fnames(srun_job_t *job)
 	job->ifname = fname_create(job, opt.ifname);
 	job->ofname = fname_create(job, opt.ofname);
 	job->efname = opt.efname ? fname_create(job, opt.efname) : job->ofname;
+	_set_direct_output(job->ofname);
+	if (job->efname != job->ofname)
+		_set_direct_output(job->efname);
+}
+
+/*
+ * With --direct-output, a single output file is opened by slurmstepd on
+ * every node rather than having all output forwarded to and written by
+ * srun. The file must be on a file system shared by the nodes.
+ */
+static void
+_set_direct_output(fname_t *fname)
+{
+	if (!opt.direct_output || (fname->type != IO_ALL) ||
+	    (fname->name == NULL) || (fname->taskid != -1))
+		return;
+
+	fname->type = IO_PER_TASK;
+	fname->direct = true;
 }
 
 static char *
@@ -79,6 +79,7 @@ typedef struct fname {
 	char      *name;
 	enum io_t  type;
 	int        taskid;  /* taskid for IO if IO_ONE */
+	bool       direct;  /* one file opened by every slurmstepd */
 } fname_t;
 
 typedef struct srun_job {